@@ -0,0 +1,145 @@
+// Cost per payment of the virtual PaymentStrategy path against the
+// variant-based PaymentMethod path, paying alternately by card and by UPI
+// as Order::processPayment does. Both paths print through cout, redirected
+// to a stream that drops the output, and end each line with a flush as the
+// strategies' endl does, so the I/O per payment is identical and the
+// difference is dispatch and allocation.
+//
+//   g++ -std=c++17 -O2 payment_dispatch.cpp -o payment_dispatch && ./payment_dispatch
+//
+// Rows:
+//   virtual       new strategy per order, pay() through the vtable, delete
+//   variant       PaymentMethod by value, pay() through the variant
+//   virtual-warm  strategies built once, only the virtual pay() timed
+//   variant-warm  methods built once, only the variant pay() timed
+
+#include<iostream>
+#include<iomanip>
+#include<sstream>
+#include<string>
+#include<vector>
+#include<chrono>
+#include<algorithm>
+#include<cstdlib>
+#include<new>
+#include "../strategies/CreditPaymentStrategies.h"
+#include "../strategies/UPIPaymentStrategy.h"
+#include "../strategies/PaymentMethod.h"
+
+using namespace std;
+
+static size_t allocations=0;
+
+void* operator new(size_t size){
+    allocations++;
+    if(void* p=malloc(size)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept{
+    free(p);
+}
+
+class NullBuffer: public streambuf{
+protected:
+    int overflow(int c) override{
+        return c;
+    }
+
+    streamsize xsputn(const char*, streamsize n) override{
+        return n;
+    }
+};
+
+template<typename F>
+double bestMillis(int runs, F fn){
+    double best=1e300;
+    for(int i=0;i<runs;i++){
+        auto start=chrono::steady_clock::now();
+        fn();
+        best=min(best, chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+    }
+    return best;
+}
+
+const string card="4111-1111-1111-1111";
+const string mobile="9876543210";
+const int payments=1000000;
+
+// The variant path writes '\n'; flushing after it matches the strategies' endl.
+void payLikeStrategy(const PaymentMethod& method, double amount){
+    pay(method, amount, cout);
+    cout.flush();
+}
+
+int main(){
+    NullBuffer null;
+    streambuf* console=cout.rdbuf(&null);
+    vector<string> lines;
+    auto report=[&](const char* name, double ns, double allocs){
+        ostringstream line;
+        line << fixed << setprecision(2) << setw(14) << name << setw(12) << ns << setw(16) << allocs;
+        lines.push_back(line.str());
+    };
+    auto measure=[&](const char* name, auto fn){
+        size_t before=allocations;
+        fn();
+        double allocs=(double)(allocations-before)/payments;
+        double ms=bestMillis(5, fn);
+        report(name, ms*1e6/payments, allocs);
+    };
+
+    measure("virtual", [&]{
+        for(int i=0;i<payments;i++){
+            PaymentStrategy* strategy;
+            if(i%2) strategy=new CreditPaymentStrategy(card);
+            else strategy=new UpiPaymentStrategy(mobile);
+            strategy->pay(100+i%50);
+            delete strategy;
+        }
+    });
+    measure("variant", [&]{
+        for(int i=0;i<payments;i++){
+            PaymentMethod method;
+            if(i%2) method=CreditPayment(card);
+            else method=UpiPayment(mobile);
+            payLikeStrategy(method, 100+i%50);
+        }
+    });
+
+    vector<PaymentStrategy*> strategies;
+    vector<PaymentMethod> methods;
+    for(int i=0;i<1024;i++){
+        if(i%2){
+            strategies.push_back(new CreditPaymentStrategy(card));
+            methods.push_back(CreditPayment(card));
+        } else {
+            strategies.push_back(new UpiPaymentStrategy(mobile));
+            methods.push_back(UpiPayment(mobile));
+        }
+    }
+    measure("virtual-warm", [&]{
+        for(int i=0;i<payments;i++){
+            strategies[i%1024]->pay(100+i%50);
+        }
+    });
+    measure("variant-warm", [&]{
+        for(int i=0;i<payments;i++){
+            payLikeStrategy(methods[i%1024], 100+i%50);
+        }
+    });
+    for(PaymentStrategy* strategy : strategies){
+        delete strategy;
+    }
+
+    cout.rdbuf(console);
+    cout << setw(14) << "" << setw(12) << "ns/payment" << setw(16) << "allocs/payment" << endl;
+    for(const string& line : lines){
+        cout << line << endl;
+    }
+    return 0;
+}
@@ -3,16 +3,71 @@
 
 #include<vector>
 #include <string>
+#include "models/Restaurant.h"
+#include "models/MenuItem.h"
+#include "managers/RestaurantManager.h"
+#include "services/MenuSearchIndex.h"
 
 using namespace std;
 
 class FoodApp{
+private:
+    vector<Restaurant*> restaurants;
+    MenuSearchIndex dishes;
+
 public:
     FoodApp(){
         initializeRestaurant();
     }
 
+    FoodApp(const FoodApp&)=delete;
+    FoodApp& operator=(const FoodApp&)=delete;
+
+    ~FoodApp(){
+        for(Restaurant* restaurant : restaurants){
+            RestaurantManager::getInstance()->closeRestaurant(restaurant->getRestaurantId());
+            delete restaurant;
+        }
+    }
+
     void initializeRestaurant(){
+        Restaurant* bikaner=new Restaurant(1, "Bikaner", "Delhi", 28.6315, 77.2167);
+        bikaner->addMenuItem(MenuItem("P1", "Chole Bhature", 120));
+        bikaner->addMenuItem(MenuItem("P2", "Samosa", 15));
 
+        Restaurant* haldiram=new Restaurant(2, "Haldiram", "Kolkata", 22.5726, 88.3639);
+        haldiram->addMenuItem(MenuItem("P1", "Raj Kachori", 80));
+        haldiram->addMenuItem(MenuItem("P2", "Pav Bhaji", 100));
+        haldiram->addMenuItem(MenuItem("P3", "Dhokla", 50));
+
+        Restaurant* saravanaBhavan=new Restaurant(3, "Saravana Bhavan", "Chennai", 13.0418, 80.2341);
+        saravanaBhavan->addMenuItem(MenuItem("P1", "Masala Dosa", 90));
+        saravanaBhavan->addMenuItem(MenuItem("P2", "Idli Vada", 60));
+        saravanaBhavan->addMenuItem(MenuItem("P3", "Filter Coffee", 30));
+
+        for(Restaurant* restaurant : {bikaner, haldiram, saravanaBhavan}){
+            restaurants.push_back(restaurant);
+            RestaurantManager::getInstance()->openRestaurant(restaurant);
+        }
+        dishes.build(restaurants);
     }
-}
\ No newline at end of file
+
+    // Open restaurants within radiusKm of the user, nearest first.
+    vector<NearbyRestaurant> searchRestaurants(double latitude, double longitude, double radiusKm){
+        return RestaurantManager::getInstance()->getRestaurantsWithin(latitude, longitude, radiusKm);
+    }
+
+    // Dish names for the search box, most popular first; tolerates one typo
+    // once the user has typed a few characters.
+    vector<Suggestion> suggestDishes(const string& typed, size_t k){
+        if(typed.size()<3) return dishes.complete(typed, k);
+        return dishes.completeFuzzy(typed, k, 1);
+    }
+
+    // The k open restaurants nearest to the user.
+    vector<NearbyRestaurant> nearestRestaurants(double latitude, double longitude, size_t k){
+        return RestaurantManager::getInstance()->getNearestRestaurants(latitude, longitude, k);
+    }
+};
+
+#endif
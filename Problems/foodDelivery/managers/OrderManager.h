@@ -0,0 +1,158 @@
+#ifndef ORDER_MANAGER_H
+#define ORDER_MANAGER_H
+
+#include<vector>
+#include<memory>
+#include<unordered_map>
+#include<shared_mutex>
+#include<mutex>
+#include<cstdint>
+#include "../models/Order.h"
+
+using namespace std;
+
+// Stores every order, safe to use from many threads at once.
+//
+// Orders are spread over shardCount shards by order id; each shard is a hash
+// map behind its own reader-writer lock, so threads working on different
+// shards never wait for each other and readers of one shard only wait for a
+// writer of that same shard. The by-user and by-restaurant indexes are
+// striped the same way. Adding and removing an order update the indexes
+// while still holding the order's shard lock, so an order and its index
+// entries come and go together; locks are always taken order shard first,
+// and lookups release the index lock before reading orders, so this cannot
+// deadlock. Status updates only take a shard's read lock: the status itself
+// is atomic.
+class OrderManager{
+private:
+    static const size_t shardCount=64;
+
+    struct OrderShard{
+        mutable shared_mutex lock;
+        unordered_map<int, shared_ptr<Order>> orders;
+    };
+
+    struct IndexShard{
+        mutable shared_mutex lock;
+        unordered_map<int, vector<int>> orderIds;
+        // Where each order id sits in its key's list.
+        unordered_map<int, size_t> positions;
+    };
+
+    OrderShard orders[shardCount];
+    IndexShard byUser[shardCount];
+    IndexShard byRestaurant[shardCount];
+
+    static size_t shardOf(int key){
+        // Spread consecutive ids across shards.
+        return (((uint32_t)key*2654435761u)>>16)%shardCount;
+    }
+
+    static void addToIndex(IndexShard* index, int key, int orderId){
+        IndexShard& shard=index[shardOf(key)];
+        unique_lock<shared_mutex> lock(shard.lock);
+        vector<int>& ids=shard.orderIds[key];
+        shard.positions[orderId]=ids.size();
+        ids.push_back(orderId);
+    }
+
+    static void removeFromIndex(IndexShard* index, int key, int orderId){
+        IndexShard& shard=index[shardOf(key)];
+        unique_lock<shared_mutex> lock(shard.lock);
+        auto it=shard.orderIds.find(key);
+        if(it==shard.orderIds.end()) return;
+        auto at=shard.positions.find(orderId);
+        if(at==shard.positions.end()) return;
+        vector<int>& ids=it->second;
+        ids[at->second]=ids.back();
+        shard.positions[ids.back()]=at->second;
+        ids.pop_back();
+        shard.positions.erase(orderId);
+        if(ids.empty()) shard.orderIds.erase(it);
+    }
+
+    vector<shared_ptr<Order>> lookup(const IndexShard* index, int key) const{
+        vector<int> ids;
+        {
+            const IndexShard& shard=index[shardOf(key)];
+            shared_lock<shared_mutex> lock(shard.lock);
+            auto it=shard.orderIds.find(key);
+            if(it!=shard.orderIds.end()) ids=it->second;
+        }
+        vector<shared_ptr<Order>> result;
+        result.reserve(ids.size());
+        for(int id : ids){
+            if(shared_ptr<Order> order=getOrder(id)) result.push_back(move(order));
+        }
+        return result;
+    }
+
+public:
+    OrderManager(){}
+    OrderManager(const OrderManager&)=delete;
+    OrderManager& operator=(const OrderManager&)=delete;
+
+    static OrderManager* getInstance(){
+        static OrderManager instance;
+        return &instance;
+    }
+
+    // Returns false if an order with the same id is already stored.
+    bool addOrder(shared_ptr<Order> order){
+        int id=order->getOrderId();
+        OrderShard& shard=orders[shardOf(id)];
+        unique_lock<shared_mutex> lock(shard.lock);
+        if(!shard.orders.emplace(id, order).second) return false;
+        if(order->getUser()) addToIndex(byUser, order->getUser()->getUserId(), id);
+        if(order->getRestaurant()) addToIndex(byRestaurant, order->getRestaurant()->getRestaurantId(), id);
+        return true;
+    }
+
+    // The order, or nullptr if there is none with this id.
+    shared_ptr<Order> getOrder(int orderId) const{
+        const OrderShard& shard=orders[shardOf(orderId)];
+        shared_lock<shared_mutex> lock(shard.lock);
+        auto it=shard.orders.find(orderId);
+        return it==shard.orders.end() ? nullptr : it->second;
+    }
+
+    bool updateStatus(int orderId, OrderStatus status){
+        const OrderShard& shard=orders[shardOf(orderId)];
+        shared_lock<shared_mutex> lock(shard.lock);
+        auto it=shard.orders.find(orderId);
+        if(it==shard.orders.end()) return false;
+        it->second->setStatus(status);
+        return true;
+    }
+
+    bool removeOrder(int orderId){
+        OrderShard& shard=orders[shardOf(orderId)];
+        unique_lock<shared_mutex> lock(shard.lock);
+        auto it=shard.orders.find(orderId);
+        if(it==shard.orders.end()) return false;
+        shared_ptr<Order> order=move(it->second);
+        shard.orders.erase(it);
+        if(order->getUser()) removeFromIndex(byUser, order->getUser()->getUserId(), orderId);
+        if(order->getRestaurant()) removeFromIndex(byRestaurant, order->getRestaurant()->getRestaurantId(), orderId);
+        return true;
+    }
+
+    vector<shared_ptr<Order>> getOrdersByUser(int userId) const{
+        return lookup(byUser, userId);
+    }
+
+    vector<shared_ptr<Order>> getOrdersByRestaurant(int restaurantId) const{
+        return lookup(byRestaurant, restaurantId);
+    }
+
+    size_t size() const{
+        size_t total=0;
+        for(const OrderShard& shard : orders){
+            shared_lock<shared_mutex> lock(shard.lock);
+            total+=shard.orders.size();
+        }
+        return total;
+    }
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef ORDER_SCHEDULER_H
+#define ORDER_SCHEDULER_H
+
+#include<vector>
+#include<memory>
+#include<functional>
+#include<unordered_map>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<chrono>
+#include<cstdint>
+#include "../models/Order.h"
+#include "../utils/TimeUtils.h"
+#include "../utils/TimingWheel.h"
+
+using namespace std;
+
+// Holds scheduled orders until they are due and then hands each one to the
+// release callback (for example to start preparing it). Orders live in a
+// TimingWheel, so scheduling and cancelling cost O(1) however many are
+// waiting, and the worker thread sleeps until the next bucket comes due
+// instead of polling.
+//
+// Time comes from the Clock passed in. With a ManualClock, tests move the
+// clock and call releaseDue() themselves instead of calling start().
+class OrderScheduler{
+public:
+    using Release=function<void(const shared_ptr<Order>&)>;
+
+private:
+    using Wheel=TimingWheel<shared_ptr<Order>>;
+
+    Clock* clock;
+    Release onDue;
+
+    mutex lock;
+    condition_variable changed;
+    Wheel wheel;
+    unordered_map<int, Wheel::TimerId> timers;
+    bool stopping=false;
+    thread worker;
+
+    void run(){
+        unique_lock<mutex> guard(lock);
+        while(!stopping){
+            int64_t next=wheel.nextDue();
+            int64_t now=clock->nowMillis();
+            if(next<=now){
+                guard.unlock();
+                releaseDue();
+                guard.lock();
+            } else if(next==INT64_MAX){
+                changed.wait(guard);
+            } else {
+                changed.wait_for(guard, chrono::milliseconds(next-now));
+            }
+        }
+    }
+
+public:
+    OrderScheduler(Clock* clock, Release onDue): wheel(clock->nowMillis()){
+        this->clock=clock;
+        this->onDue=onDue;
+    }
+
+    OrderScheduler(const OrderScheduler&)=delete;
+    OrderScheduler& operator=(const OrderScheduler&)=delete;
+
+    ~OrderScheduler(){
+        {
+            lock_guard<mutex> guard(lock);
+            stopping=true;
+        }
+        changed.notify_one();
+        if(worker.joinable()) worker.join();
+    }
+
+    // Releases due orders from a background thread from now on.
+    void start(){
+        if(!worker.joinable()) worker=thread(&OrderScheduler::run, this);
+    }
+
+    // Holds order until dueMillis on the scheduler's clock. Returns false if
+    // the order is already scheduled.
+    bool schedule(const shared_ptr<Order>& order, int64_t dueMillis){
+        bool earlier;
+        {
+            lock_guard<mutex> guard(lock);
+            if(timers.count(order->getOrderId())) return false;
+            earlier=dueMillis<wheel.nextDue();
+            timers[order->getOrderId()]=wheel.schedule(dueMillis, order);
+        }
+        // The worker only needs waking if it is sleeping past this order.
+        if(earlier) changed.notify_one();
+        return true;
+    }
+
+    // Returns false if the order is not waiting (never scheduled, already
+    // released or already cancelled).
+    bool cancel(int orderId){
+        lock_guard<mutex> guard(lock);
+        auto it=timers.find(orderId);
+        if(it==timers.end()) return false;
+        wheel.cancel(it->second);
+        timers.erase(it);
+        return true;
+    }
+
+    // Releases every order due by the clock's current time, earliest first,
+    // and returns how many there were. The callback runs without the lock
+    // held, so it may schedule or cancel orders.
+    size_t releaseDue(){
+        vector<shared_ptr<Order>> due;
+        {
+            lock_guard<mutex> guard(lock);
+            wheel.advance(clock->nowMillis(), [&](shared_ptr<Order>& order){
+                timers.erase(order->getOrderId());
+                due.push_back(move(order));
+            });
+        }
+        for(const shared_ptr<Order>& order : due){
+            onDue(order);
+        }
+        return due.size();
+    }
+
+    size_t size(){
+        lock_guard<mutex> guard(lock);
+        return wheel.size();
+    }
+};
+
+#endif
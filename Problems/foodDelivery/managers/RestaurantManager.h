@@ -0,0 +1,263 @@
+#ifndef RESTAURANT_MANAGER_H
+#define RESTAURANT_MANAGER_H
+
+#include<vector>
+#include<unordered_map>
+#include<shared_mutex>
+#include<mutex>
+#include<algorithm>
+#include<cmath>
+#include<cstdint>
+#include "../models/Restaurant.h"
+
+using namespace std;
+
+struct NearbyRestaurant{
+    Restaurant* restaurant;
+    double distanceKm;
+};
+
+// Registry of open restaurants, indexed by position so that the ones near a
+// user can be listed without looking at the rest. Safe to use from many
+// threads at once.
+//
+// The map is cut into a uniform grid of cellDegrees x cellDegrees cells.
+// Each open restaurant sits in the cell holding its coordinates; a query
+// only visits the cells that can hold an answer. Cells are spread over
+// shardCount shards, each behind its own reader-writer lock, so queries
+// proceed in parallel and only wait for an open or close touching the same
+// shard. Restaurants are not owned.
+class RestaurantManager{
+private:
+    static const size_t shardCount=64;
+    static constexpr double cellDegrees=0.01;  // about 1.1 km north-south
+    static constexpr double kmPerDegree=111.195;
+    static constexpr double earthRadiusKm=6371.0;
+
+    struct Entry{
+        Restaurant* restaurant;
+        double latitude;
+        double longitude;
+    };
+
+    struct CellShard{
+        mutable shared_mutex lock;
+        unordered_map<uint64_t, vector<Entry>> cells;
+    };
+
+    struct IdShard{
+        mutable shared_mutex lock;
+        unordered_map<int, uint64_t> cellOf;
+    };
+
+    CellShard cells[shardCount];
+    IdShard ids[shardCount];
+
+    static int64_t rows(){
+        return (int64_t)ceil(180/cellDegrees);
+    }
+
+    static int64_t columns(){
+        return (int64_t)ceil(360/cellDegrees);
+    }
+
+    static int64_t rowOf(double latitude){
+        return min<int64_t>(rows()-1, max<int64_t>(0, (int64_t)floor((latitude+90)/cellDegrees)));
+    }
+
+    static int64_t columnOf(double longitude){
+        int64_t column=(int64_t)floor((longitude+180)/cellDegrees)%columns();
+        return column<0 ? column+columns() : column;
+    }
+
+    // Wraps around in longitude; rows past the poles have no key.
+    static uint64_t keyOf(int64_t row, int64_t column){
+        column%=columns();
+        if(column<0) column+=columns();
+        return (uint64_t)row*columns()+column;
+    }
+
+    static size_t shardOf(uint64_t key){
+        return (size_t)((key*0x9E3779B97F4A7C15ull)>>58)%shardCount;
+    }
+
+    static size_t idShardOf(int id){
+        return (((uint32_t)id*2654435761u)>>16)%shardCount;
+    }
+
+    static double distanceKm(double lat1, double lon1, double lat2, double lon2){
+        const double radians=M_PI/180;
+        double dLat=(lat2-lat1)*radians;
+        double dLon=(lon2-lon1)*radians;
+        double a=sin(dLat/2)*sin(dLat/2)+cos(lat1*radians)*cos(lat2*radians)*sin(dLon/2)*sin(dLon/2);
+        return 2*earthRadiusKm*asin(min(1.0, sqrt(a)));
+    }
+
+    // Calls fn(entry) for every restaurant in cell (row, column).
+    template<typename F>
+    void scanCell(int64_t row, int64_t column, F fn) const{
+        if(row<0 || row>=rows()) return;
+        uint64_t key=keyOf(row, column);
+        const CellShard& shard=cells[shardOf(key)];
+        shared_lock<shared_mutex> lock(shard.lock);
+        auto it=shard.cells.find(key);
+        if(it==shard.cells.end()) return;
+        for(const Entry& entry : it->second){
+            fn(entry);
+        }
+    }
+
+    // Calls fn on every cell of the square ring at distance ring from
+    // (row, column).
+    template<typename F>
+    void scanRing(int64_t row, int64_t column, int64_t ring, F fn) const{
+        if(ring==0){
+            scanCell(row, column, fn);
+            return;
+        }
+        for(int64_t c=column-ring;c<=column+ring;c++){
+            scanCell(row-ring, c, fn);
+            scanCell(row+ring, c, fn);
+        }
+        for(int64_t r=row-ring+1;r<=row+ring-1;r++){
+            scanCell(r, column-ring, fn);
+            scanCell(r, column+ring, fn);
+        }
+    }
+
+    // East-west size of a degree shrinks towards the poles; clamped so
+    // polar queries stay bounded.
+    static double shrinkAt(double latitude){
+        return cos(min(89.0, fabs(latitude))*M_PI/180);
+    }
+
+    // Rings needed to cover radiusKm around latitude. Never more than half
+    // the globe, so a ring does not meet itself round the back.
+    static int64_t ringsFor(double latitude, double radiusKm){
+        double shrink=shrinkAt(fabs(latitude)+radiusKm/kmPerDegree);
+        int64_t rings=(int64_t)ceil(radiusKm/(kmPerDegree*cellDegrees*shrink))+1;
+        return min(rings, columns()/2-1);
+    }
+
+    // Lower bound on the distance from a point in the centre cell to any
+    // cell of ring or beyond.
+    static double ringDistanceKm(double latitude, int64_t ring){
+        if(ring<=1) return 0;
+        return (ring-1)*cellDegrees*kmPerDegree*shrinkAt(fabs(latitude)+(ring+1)*cellDegrees);
+    }
+
+public:
+    RestaurantManager(){}
+    RestaurantManager(const RestaurantManager&)=delete;
+    RestaurantManager& operator=(const RestaurantManager&)=delete;
+
+    static RestaurantManager* getInstance(){
+        static RestaurantManager instance;
+        return &instance;
+    }
+
+    // Makes restaurant findable at its current coordinates. Returns false if
+    // a restaurant with the same id is already open.
+    bool openRestaurant(Restaurant* restaurant){
+        int id=restaurant->getRestaurantId();
+        double latitude=restaurant->getLatitude();
+        double longitude=restaurant->getLongitude();
+        uint64_t key=keyOf(rowOf(latitude), columnOf(longitude));
+        IdShard& idShard=ids[idShardOf(id)];
+        unique_lock<shared_mutex> idLock(idShard.lock);
+        if(!idShard.cellOf.emplace(id, key).second) return false;
+        CellShard& shard=cells[shardOf(key)];
+        unique_lock<shared_mutex> lock(shard.lock);
+        shard.cells[key].push_back({restaurant, latitude, longitude});
+        return true;
+    }
+
+    // Returns false if no open restaurant has this id.
+    bool closeRestaurant(int restaurantId){
+        IdShard& idShard=ids[idShardOf(restaurantId)];
+        unique_lock<shared_mutex> idLock(idShard.lock);
+        auto found=idShard.cellOf.find(restaurantId);
+        if(found==idShard.cellOf.end()) return false;
+        uint64_t key=found->second;
+        idShard.cellOf.erase(found);
+        CellShard& shard=cells[shardOf(key)];
+        unique_lock<shared_mutex> lock(shard.lock);
+        auto it=shard.cells.find(key);
+        vector<Entry>& entries=it->second;
+        for(size_t i=0;i<entries.size();i++){
+            if(entries[i].restaurant->getRestaurantId()!=restaurantId) continue;
+            entries[i]=entries.back();
+            entries.pop_back();
+            break;
+        }
+        if(entries.empty()) shard.cells.erase(it);
+        return true;
+    }
+
+    bool isOpen(int restaurantId) const{
+        const IdShard& idShard=ids[idShardOf(restaurantId)];
+        shared_lock<shared_mutex> lock(idShard.lock);
+        return idShard.cellOf.count(restaurantId)>0;
+    }
+
+    // Open restaurants within radiusKm of (latitude, longitude), nearest
+    // first.
+    vector<NearbyRestaurant> getRestaurantsWithin(double latitude, double longitude, double radiusKm) const{
+        vector<NearbyRestaurant> result;
+        int64_t row=rowOf(latitude);
+        int64_t column=columnOf(longitude);
+        int64_t rings=ringsFor(latitude, radiusKm);
+        for(int64_t ring=0;ring<=rings;ring++){
+            scanRing(row, column, ring, [&](const Entry& entry){
+                double km=distanceKm(latitude, longitude, entry.latitude, entry.longitude);
+                if(km<=radiusKm) result.push_back({entry.restaurant, km});
+            });
+        }
+        sort(result.begin(), result.end(), [](const NearbyRestaurant& a, const NearbyRestaurant& b){
+            return a.distanceKm<b.distanceKm;
+        });
+        return result;
+    }
+
+    // The k open restaurants nearest to (latitude, longitude), nearest
+    // first, looking no further than maxKm.
+    vector<NearbyRestaurant> getNearestRestaurants(double latitude, double longitude, size_t k, double maxKm=50) const{
+        vector<NearbyRestaurant> best;
+        if(k==0) return best;
+        auto farther=[](const NearbyRestaurant& a, const NearbyRestaurant& b){
+            return a.distanceKm<b.distanceKm;
+        };
+        int64_t row=rowOf(latitude);
+        int64_t column=columnOf(longitude);
+        int64_t rings=ringsFor(latitude, maxKm);
+        for(int64_t ring=0;ring<=rings;ring++){
+            // best is a max-heap on distance holding at most k entries.
+            if(best.size()==k && best.front().distanceKm<=ringDistanceKm(latitude, ring)) break;
+            scanRing(row, column, ring, [&](const Entry& entry){
+                double km=distanceKm(latitude, longitude, entry.latitude, entry.longitude);
+                if(km>maxKm) return;
+                if(best.size()<k){
+                    best.push_back({entry.restaurant, km});
+                    push_heap(best.begin(), best.end(), farther);
+                } else if(km<best.front().distanceKm){
+                    pop_heap(best.begin(), best.end(), farther);
+                    best.back()={entry.restaurant, km};
+                    push_heap(best.begin(), best.end(), farther);
+                }
+            });
+        }
+        sort_heap(best.begin(), best.end(), farther);
+        return best;
+    }
+
+    size_t size() const{
+        size_t total=0;
+        for(const IdShard& shard : ids){
+            shared_lock<shared_mutex> lock(shard.lock);
+            total+=shard.cellOf.size();
+        }
+        return total;
+    }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef CART_H
+#define CART_H
+
+#include<string>
+#include<string_view>
+#include<cstdint>
+#include "MenuItem.h"
+#include "Restaurant.h"
+#include "../utils/SmallVector.h"
+
+using namespace std;
+
+// One line of a cart: an item of the restaurant's MenuCatalog, the price it
+// was added at and how many. Code and name are read from the catalog when
+// shown, so a line is three ints and copying it never allocates.
+struct CartLine{
+    uint32_t itemId;
+    int price;
+    int quantity;
+};
+
+// Lines of a cart or an order; up to eight distinct items are kept inline.
+using CartLines=SmallVector<CartLine, 8>;
+
+// Items a user is about to order from one restaurant. Lines live in a
+// SmallVector, so a cart of up to eight distinct items never touches the
+// heap. The subtotal and the item count are updated on every add and
+// remove, so reading them, the tax or the total is O(1).
+//
+// Items are added by catalog id or code and must be on the menu of the
+// cart's restaurant. If an item's price changes while it is in the cart,
+// later additions go on a new line at the new price.
+class Cart{
+private:
+    Restaurant* restaurant=nullptr;
+    CartLines lines;
+    int64_t subtotal=0;
+    int itemCount=0;
+    double taxRate=0;
+
+    int findLine(uint32_t itemId, int price) const{
+        for(size_t i=0;i<lines.size();i++){
+            if(lines[i].itemId==itemId && lines[i].price==price) return i;
+        }
+        return -1;
+    }
+
+    int findLine(uint32_t itemId) const{
+        for(size_t i=0;i<lines.size();i++){
+            if(lines[i].itemId==itemId) return i;
+        }
+        return -1;
+    }
+
+    uint32_t idOf(string_view code) const{
+        return restaurant==nullptr ? MenuCatalog::npos : restaurant->getMenu().find(code);
+    }
+
+public:
+    // Switching restaurant empties the cart.
+    void setRestaurant(Restaurant* r){
+        if(r!=restaurant) clear();
+        restaurant=r;
+    }
+
+    Restaurant* getRestaurant() const{
+        return restaurant;
+    }
+
+    // Adds quantity of the menu item with this id at its current price,
+    // merging with a line for the same item and price. Returns false if the
+    // item is not on the restaurant's menu.
+    bool addItem(uint32_t itemId, int quantity=1){
+        if(quantity<=0 || restaurant==nullptr || itemId>=restaurant->getMenu().size()) return false;
+        int price=restaurant->getMenu().getPrice(itemId);
+        int line=findLine(itemId, price);
+        if(line<0){
+            lines.push_back({itemId, price, quantity});
+        } else {
+            lines[line].quantity+=quantity;
+        }
+        subtotal+=(int64_t)price*quantity;
+        itemCount+=quantity;
+        return true;
+    }
+
+    bool addItem(string_view code, int quantity=1){
+        return addItem(idOf(code), quantity);
+    }
+
+    bool addItem(const MenuItem& item, int quantity=1){
+        return addItem(item.getCode(), quantity);
+    }
+
+    // Removes up to quantity of the item, from whichever lines hold it;
+    // returns how many were removed.
+    int removeItem(uint32_t itemId, int quantity=1){
+        int removed=0;
+        int line;
+        while(removed<quantity && (line=findLine(itemId))>=0){
+            CartLine& entry=lines[line];
+            int take=quantity-removed<entry.quantity ? quantity-removed : entry.quantity;
+            subtotal-=(int64_t)entry.price*take;
+            itemCount-=take;
+            entry.quantity-=take;
+            if(entry.quantity==0) lines.erase(line);
+            removed+=take;
+        }
+        return removed;
+    }
+
+    int removeItem(string_view code, int quantity=1){
+        return removeItem(idOf(code), quantity);
+    }
+
+    void clear(){
+        lines.clear();
+        subtotal=0;
+        itemCount=0;
+    }
+
+    bool isEmpty() const{
+        return lines.empty();
+    }
+
+    const CartLines& getLines() const{
+        return lines;
+    }
+
+    int getItemCount() const{
+        return itemCount;
+    }
+
+    int64_t getSubtotal() const{
+        return subtotal;
+    }
+
+    // Fraction of the subtotal charged as tax, e.g. 0.05.
+    void setTaxRate(double rate){
+        taxRate=rate;
+    }
+
+    double getTax() const{
+        return subtotal*taxRate;
+    }
+
+    double getTotal() const{
+        return subtotal+getTax();
+    }
+};
+
+#endif
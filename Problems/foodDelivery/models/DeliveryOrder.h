@@ -0,0 +1,27 @@
+#ifndef DELIVERY_ORDER_H
+#define DELIVERY_ORDER_H
+
+#include<string>
+#include<string_view>
+#include "Order.h"
+using namespace std;
+
+class DeliveryOrder: public Order{
+private:
+    string userAddress;
+
+public:
+    string_view getType() const override{
+        return "Delivery";
+    }
+
+    void setUserAddress(const string& address){
+        userAddress=address;
+    }
+
+    const string& getUserAddress() const{
+        return userAddress;
+    }
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef MENU_CATALOG_H
+#define MENU_CATALOG_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+#include<functional>
+#include<stdexcept>
+#include<cstring>
+#include<cstdint>
+using namespace std;
+
+// A read-only view of one catalog entry. The views stay valid until the
+// next addItem() on the catalog they came from.
+struct MenuItemView{
+    uint32_t id;
+    string_view code;
+    string_view name;
+    int price;
+};
+
+// One restaurant's menu, stored column by column. Each item code is interned
+// to a dense id (0, 1, 2, ...) that indexes the columns directly; all code
+// and name bytes live in one shared buffer. find() hashes the code into an
+// open-addressing table of ids, so a lookup is O(1) and, like every other
+// read, never allocates.
+//
+// A renamed item's name is overwritten in place when the new one fits;
+// otherwise the old bytes are left behind and counted, and once they
+// outweigh the live ones the buffer is repacked, so repeated menu updates
+// keep it within about twice the live text.
+class MenuCatalog{
+private:
+    struct Span{
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    static constexpr uint32_t emptySlot=UINT32_MAX;
+
+    string text;
+    // Bytes of text no longer referenced by any span.
+    size_t wastedBytes=0;
+    vector<Span> codes;
+    vector<Span> names;
+    vector<int> prices;
+    // Power-of-two table of item ids, kept at most half full.
+    vector<uint32_t> slots;
+
+    string_view view(Span span) const{
+        return string_view(text).substr(span.offset, span.length);
+    }
+
+    Span append(string_view s){
+        if(s.size()>UINT32_MAX-text.size()) throw length_error("MenuCatalog: text past 4 GB");
+        Span span={(uint32_t)text.size(), (uint32_t)s.size()};
+        text.append(s.data(), s.size());
+        return span;
+    }
+
+    void rename(uint32_t id, string_view name){
+        Span& span=names[id];
+        if(name.size()<=span.length){
+            memmove(&text[span.offset], name.data(), name.size());
+            wastedBytes+=span.length-name.size();
+            span.length=name.size();
+        } else {
+            wastedBytes+=span.length;
+            span=append(name);
+        }
+        if(wastedBytes>text.size()-wastedBytes) repack();
+    }
+
+    // Copies the live codes and names into a fresh buffer.
+    void repack(){
+        string packed;
+        packed.reserve(text.size()-wastedBytes);
+        for(vector<Span>* column : {&codes, &names}){
+            for(Span& span : *column){
+                uint32_t offset=packed.size();
+                packed.append(text, span.offset, span.length);
+                span.offset=offset;
+            }
+        }
+        text.swap(packed);
+        wastedBytes=0;
+    }
+
+    size_t slotFor(string_view code) const{
+        size_t mask=slots.size()-1;
+        size_t slot=hash<string_view>()(code)&mask;
+        while(slots[slot]!=emptySlot && view(codes[slots[slot]])!=code){
+            slot=(slot+1)&mask;
+        }
+        return slot;
+    }
+
+    void grow(){
+        slots.assign(slots.empty() ? 16 : slots.size()*2, emptySlot);
+        for(uint32_t id=0;id<codes.size();id++){
+            slots[slotFor(view(codes[id]))]=id;
+        }
+    }
+
+public:
+    static constexpr uint32_t npos=UINT32_MAX;
+
+    void reserve(size_t items, size_t textBytes){
+        codes.reserve(items);
+        names.reserve(items);
+        prices.reserve(items);
+        text.reserve(textBytes);
+    }
+
+    // Adds an item and returns its id. Adding a code that is already on the
+    // menu updates that item instead. Throws length_error once the codes and
+    // names would pass 4 GB.
+    uint32_t addItem(string_view code, string_view name, int price){
+        if((codes.size()+1)*2>slots.size()) grow();
+        size_t slot=slotFor(code);
+        if(slots[slot]!=emptySlot){
+            uint32_t id=slots[slot];
+            if(view(names[id])!=name) rename(id, name);
+            prices[id]=price;
+            return id;
+        }
+        uint32_t id=codes.size();
+        codes.push_back(append(code));
+        names.push_back(append(name));
+        prices.push_back(price);
+        slots[slot]=id;
+        return id;
+    }
+
+    // Id of the item with this code, or npos.
+    uint32_t find(string_view code) const{
+        if(slots.empty()) return npos;
+        return slots[slotFor(code)];
+    }
+
+    size_t size() const{
+        return codes.size();
+    }
+
+    // Bytes held for codes and names, including any not yet repacked.
+    size_t textBytes() const{
+        return text.size();
+    }
+
+    string_view getCode(uint32_t id) const{
+        return view(codes[id]);
+    }
+
+    string_view getName(uint32_t id) const{
+        return view(names[id]);
+    }
+
+    int getPrice(uint32_t id) const{
+        return prices[id];
+    }
+
+    void setPrice(uint32_t id, int price){
+        prices[id]=price;
+    }
+
+    MenuItemView item(uint32_t id) const{
+        return {id, view(codes[id]), view(names[id]), prices[id]};
+    }
+};
+
+#endif
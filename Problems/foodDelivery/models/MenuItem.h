@@ -18,19 +18,19 @@ public:
 
     }
     
-    string getCode() const{
+    const string& getCode() const{
         return code;
     }
 
-    void setCode(string &c){
+    void setCode(const string &c){
         code=c;
     }
 
-    string getName() const{
+    const string& getName() const{
         return name;
     }
 
-    string setName(string &nm) {
+    void setName(const string &nm) {
         name=nm;
     }
 
@@ -38,8 +38,8 @@ public:
         return price;
     }
 
-    void setPrice(int &p){
+    void setPrice(int p){
         price=p;
     }
 };
-#endif
\ No newline at end of file
+#endif
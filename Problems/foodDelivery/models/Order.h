@@ -3,9 +3,150 @@
 
 #include<iostream>
 #include<string>
+#include<string_view>
 #include<vector>
-#include<User.h>
-#include<Restaurant.h>
-#include<MenuItem.h>
-#include<
+#include<atomic>
+#include "User.h"
+#include "Restaurant.h"
+#include "MenuItem.h"
+#include "Cart.h"
+#include "../strategies/PaymentStrategy.h"
+#include "../strategies/PaymentMethod.h"
 
+using namespace std;
+
+enum class OrderStatus{
+    PLACED,
+    PREPARING,
+    OUT_FOR_DELIVERY,
+    DELIVERED,
+    CANCELLED
+};
+
+class Order{
+protected:
+    static inline atomic<int> nextOrderId{0};
+
+    int orderId;
+    User* user=nullptr;
+    Restaurant* restaurant=nullptr;
+    CartLines items;
+    int itemCount=0;
+    // A built-in method if one was chosen, otherwise a plug-in strategy.
+    PaymentMethod paymentMethod;
+    PaymentStrategy* paymentStrategy=nullptr;
+    double total=0;
+    string scheduled;
+    // Updated from any thread while others read the order.
+    atomic<OrderStatus> status{OrderStatus::PLACED};
+
+public:
+    Order(){
+        orderId=++nextOrderId;
+    }
+
+    virtual ~Order(){
+        delete paymentStrategy;
+    }
+
+    Order(const Order&)=delete;
+    Order& operator=(const Order&)=delete;
+
+    bool processPayment(){
+        if(pay(paymentMethod, total)) return true;
+        if(paymentStrategy==nullptr){
+            cout << "Please choose a payment mode first" << endl;
+            return false;
+        }
+        paymentStrategy->pay(total);
+        return true;
+    }
+
+    // A name with static storage, e.g. "Delivery".
+    virtual string_view getType() const=0;
+
+    int getOrderId() const{
+        return orderId;
+    }
+
+    void setUser(User* u){
+        user=u;
+    }
+
+    User* getUser() const{
+        return user;
+    }
+
+    void setRestaurant(Restaurant* r){
+        restaurant=r;
+    }
+
+    Restaurant* getRestaurant() const{
+        return restaurant;
+    }
+
+    // Copies the cart's lines, which are plain ids and numbers, and its
+    // already computed total. The lines refer to the cart's restaurant's
+    // menu, so that becomes the order's restaurant.
+    void setItems(const Cart& cart){
+        if(cart.getRestaurant()!=nullptr) restaurant=cart.getRestaurant();
+        items=cart.getLines();
+        itemCount=cart.getItemCount();
+        total=cart.getTotal();
+    }
+
+    // Items must be on the menu of the order's restaurant; others are
+    // skipped.
+    void setItems(const vector<MenuItem>& its){
+        Cart cart;
+        cart.setRestaurant(restaurant);
+        for(const auto& item : its){
+            cart.addItem(item);
+        }
+        setItems(cart);
+    }
+
+    const CartLines& getItems() const{
+        return items;
+    }
+
+    int getItemCount() const{
+        return itemCount;
+    }
+
+    // Takes ownership of the strategy.
+    void setPaymentStrategy(PaymentStrategy* p){
+        delete paymentStrategy;
+        paymentStrategy=p;
+    }
+
+    void setPaymentMethod(const PaymentMethod& method){
+        paymentMethod=method;
+    }
+
+    const PaymentMethod& getPaymentMethod() const{
+        return paymentMethod;
+    }
+
+    double getTotal() const{
+        return total;
+    }
+
+    void setScheduled(const string& s){
+        scheduled=s;
+    }
+
+    const string& getScheduled() const{
+        return scheduled;
+    }
+
+    OrderStatus getStatus() const{
+        return status.load(memory_order_acquire);
+    }
+
+    void setStatus(OrderStatus s){
+        status.store(s, memory_order_release);
+    }
+};
+
+#endif
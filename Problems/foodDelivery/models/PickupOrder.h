@@ -0,0 +1,27 @@
+#ifndef PICKUP_ORDER_H
+#define PICKUP_ORDER_H
+
+#include<string>
+#include<string_view>
+#include "Order.h"
+using namespace std;
+
+class PickupOrder: public Order{
+private:
+    string restaurantAddress;
+
+public:
+    string_view getType() const override{
+        return "Pickup";
+    }
+
+    void setRestaurantAddress(const string& address){
+        restaurantAddress=address;
+    }
+
+    const string& getRestaurantAddress() const{
+        return restaurantAddress;
+    }
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef RESTAURANT_H
+#define RESTAURANT_H
+
+#include<string>
+#include "MenuItem.h"
+#include "MenuCatalog.h"
+using namespace std;
+
+class Restaurant{
+private:
+    int restaurantId;
+    string name;
+    string location;
+    double latitude;
+    double longitude;
+    MenuCatalog menu;
+
+public:
+    Restaurant(int restaurantId, const string& name, const string& location, double latitude=0, double longitude=0){
+        this->restaurantId=restaurantId;
+        this->name=name;
+        this->location=location;
+        this->latitude=latitude;
+        this->longitude=longitude;
+    }
+
+    int getRestaurantId() const{
+        return restaurantId;
+    }
+
+    const string& getName() const{
+        return name;
+    }
+
+    const string& getLocation() const{
+        return location;
+    }
+
+    double getLatitude() const{
+        return latitude;
+    }
+
+    double getLongitude() const{
+        return longitude;
+    }
+
+    void addMenuItem(const MenuItem& item){
+        menu.addItem(item.getCode(), item.getName(), item.getPrice());
+    }
+
+    const MenuCatalog& getMenu() const{
+        return menu;
+    }
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef USER_H
+#define USER_H
+
+#include<string>
+using namespace std;
+
+class User{
+private:
+    int userId;
+    string name;
+    string address;
+
+public:
+    User(int userId, const string& name, const string& address){
+        this->userId=userId;
+        this->name=name;
+        this->address=address;
+    }
+
+    int getUserId() const{
+        return userId;
+    }
+
+    const string& getName() const{
+        return name;
+    }
+
+    void setName(const string& n){
+        name=n;
+    }
+
+    const string& getAddress() const{
+        return address;
+    }
+
+    void setAddress(const string& a){
+        address=a;
+    }
+};
+
+#endif
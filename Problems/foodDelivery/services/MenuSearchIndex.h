@@ -0,0 +1,430 @@
+#ifndef MENU_SEARCH_INDEX_H
+#define MENU_SEARCH_INDEX_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+#include<queue>
+#include<unordered_map>
+#include<unordered_set>
+#include<shared_mutex>
+#include<mutex>
+#include<algorithm>
+#include<cctype>
+#include<cmath>
+#include<cstdint>
+#include "../models/Restaurant.h"
+
+using namespace std;
+
+struct MenuItemRef{
+    int restaurantId;
+    string code;
+};
+
+struct Suggestion{
+    string name;
+    double popularity;
+    int edits;                  // typos between the query and this name
+    vector<MenuItemRef> items;  // every menu item with this name
+};
+
+// Autocomplete over the dish names of every restaurant's menu. Names are
+// compared lowercased and match from the start of any of their words; each
+// distinct name is one entry ranked by its popularity, which callers raise
+// as orders come in.
+//
+// Names live in a radix trie (runs of single-child nodes merged into one
+// labelled edge). Every node also stores the highest popularity below it,
+// so the top k completions of a prefix come out of a best-first walk that
+// only opens the nodes that can still beat the k-th result, however many
+// names share the prefix. Typo-tolerant lookup walks the trie with a row of
+// the edit-distance table per character and drops a branch as soon as the
+// whole row is over the limit.
+//
+// Safe to use from many threads: queries share a reader-writer lock that
+// updates take exclusively.
+class MenuSearchIndex{
+private:
+    static constexpr uint32_t none=UINT32_MAX;
+    static constexpr double empty=-INFINITY;
+
+    struct Node{
+        string label;
+        vector<uint32_t> children;  // sorted by first label byte
+        uint32_t parent;
+        vector<uint32_t> terms;     // names with a key ending here
+        double best=empty;          // highest popularity in this subtree
+    };
+
+    struct Term{
+        string name;
+        double popularity;
+        vector<MenuItemRef> items;
+        vector<uint32_t> nodes;     // one per key
+    };
+
+    mutable shared_mutex lock;
+    vector<Node> nodes;
+    vector<Term> terms;
+    vector<uint32_t> freeTerms;
+    unordered_map<string, uint32_t> termIds;
+
+    static string normalize(string_view name){
+        size_t begin=0, end=name.size();
+        while(begin<end && isspace((unsigned char)name[begin])) begin++;
+        while(end>begin && isspace((unsigned char)name[end-1])) end--;
+        string key(name.substr(begin, end-begin));
+        for(char& c : key){
+            c=tolower((unsigned char)c);
+        }
+        return key;
+    }
+
+    uint32_t newNode(string label, uint32_t parent){
+        nodes.push_back(Node());
+        nodes.back().label=move(label);
+        nodes.back().parent=parent;
+        return nodes.size()-1;
+    }
+
+    void attach(uint32_t parent, uint32_t child){
+        vector<uint32_t>& children=nodes[parent].children;
+        unsigned char first=nodes[child].label[0];
+        auto at=lower_bound(children.begin(), children.end(), first, [&](uint32_t c, unsigned char b){
+            return (unsigned char)nodes[c].label[0]<b;
+        });
+        children.insert(at, child);
+        nodes[child].parent=parent;
+    }
+
+    uint32_t childStartingWith(uint32_t node, unsigned char first) const{
+        const vector<uint32_t>& children=nodes[node].children;
+        auto at=lower_bound(children.begin(), children.end(), first, [&](uint32_t c, unsigned char b){
+            return (unsigned char)nodes[c].label[0]<b;
+        });
+        return at!=children.end() && (unsigned char)nodes[*at].label[0]==first ? *at : none;
+    }
+
+    // The node that ends exactly at key, created (splitting an edge if
+    // needed) when missing.
+    uint32_t nodeFor(const string& key){
+        uint32_t node=0;
+        size_t pos=0;
+        while(pos<key.size()){
+            uint32_t child=childStartingWith(node, key[pos]);
+            if(child==none){
+                uint32_t leaf=newNode(key.substr(pos), node);
+                attach(node, leaf);
+                return leaf;
+            }
+            size_t labelSize=nodes[child].label.size();
+            size_t common=0;
+            while(common<labelSize && pos+common<key.size() && nodes[child].label[common]==key[pos+common]) common++;
+            if(common<labelSize){
+                // Split the edge: node -> middle -> child.
+                uint32_t middle=newNode(nodes[child].label.substr(0, common), node);
+                replace(nodes[node].children.begin(), nodes[node].children.end(), child, middle);
+                nodes[child].label.erase(0, common);
+                nodes[middle].children.push_back(child);
+                nodes[child].parent=middle;
+                nodes[middle].best=nodes[child].best;
+                child=middle;
+            }
+            node=child;
+            pos+=common;
+        }
+        return node;
+    }
+
+    double ownScore(const Node& node) const{
+        double best=empty;
+        for(uint32_t term : node.terms){
+            best=max(best, terms[term].popularity);
+        }
+        return best;
+    }
+
+    // Recomputes best from node up to the root, stopping once it no longer
+    // changes.
+    void refresh(uint32_t node){
+        while(node!=none){
+            double best=ownScore(nodes[node]);
+            for(uint32_t child : nodes[node].children){
+                best=max(best, nodes[child].best);
+            }
+            if(best==nodes[node].best && node!=0) return;
+            nodes[node].best=best;
+            node=nodes[node].parent;
+        }
+    }
+
+    // A name is found from the start of each of its words, so "dosa" finds
+    // "masala dosa".
+    static vector<string> keysOf(const string& key){
+        vector<string> keys={key};
+        for(size_t i=1;i<key.size();i++){
+            if(key[i-1]==' ' && key[i]!=' ') keys.push_back(key.substr(i));
+        }
+        return keys;
+    }
+
+    void refreshTerm(const Term& term){
+        for(uint32_t node : term.nodes){
+            refresh(node);
+        }
+    }
+
+    uint32_t addTerm(const string& key, string_view name, bool propagate){
+        auto it=termIds.find(key);
+        if(it!=termIds.end()) return it->second;
+        uint32_t id;
+        if(!freeTerms.empty()){
+            id=freeTerms.back();
+            freeTerms.pop_back();
+        } else {
+            id=terms.size();
+            terms.push_back(Term());
+        }
+        Term& term=terms[id];
+        term.name=string(name);
+        term.popularity=0;
+        term.items.clear();
+        term.nodes.clear();
+        for(const string& k : keysOf(key)){
+            uint32_t node=nodeFor(k);
+            nodes[node].terms.push_back(id);
+            terms[id].nodes.push_back(node);
+            if(propagate) refresh(node);
+        }
+        termIds.emplace(key, id);
+        return id;
+    }
+
+    void addRef(const string& key, string_view name, int restaurantId, string_view code, bool propagate){
+        Term& term=terms[addTerm(key, name, propagate)];
+        for(const MenuItemRef& ref : term.items){
+            if(ref.restaurantId==restaurantId && ref.code==code) return;
+        }
+        term.items.push_back({restaurantId, string(code)});
+    }
+
+    // Sets best for the whole trie bottom-up, after a bulk build.
+    double rebuildBest(uint32_t node){
+        double best=ownScore(nodes[node]);
+        for(uint32_t child : nodes[node].children){
+            best=max(best, rebuildBest(child));
+        }
+        nodes[node].best=best;
+        return best;
+    }
+
+    // Node where the names starting with key begin (key may end inside its
+    // label), or none.
+    uint32_t findPrefix(const string& key) const{
+        uint32_t node=0;
+        size_t pos=0;
+        while(pos<key.size()){
+            uint32_t child=childStartingWith(node, key[pos]);
+            if(child==none) return none;
+            const string& label=nodes[child].label;
+            size_t common=0;
+            while(common<label.size() && pos+common<key.size() && label[common]==key[pos+common]) common++;
+            if(pos+common==key.size()) return child;
+            if(common<label.size()) return none;
+            node=child;
+            pos+=common;
+        }
+        return node;
+    }
+
+    // Walks the trie keeping one edit-distance row per character. Once the
+    // whole query is within maxEdits of the path so far, every name below
+    // matches and the node is recorded; the walk goes on only while a
+    // longer path could match with fewer edits.
+    void fuzzyWalk(uint32_t node, const string& query, vector<int> row, int maxEdits, int matched,
+                   vector<pair<uint32_t, int>>& matches) const{
+        size_t m=query.size();
+        vector<int> next(m+1);
+        for(char c : nodes[node].label){
+            next[0]=row[0]+1;
+            int lowest=next[0];
+            for(size_t j=1;j<=m;j++){
+                int substitute=row[j-1]+(query[j-1]==c ? 0 : 1);
+                next[j]=min(substitute, min(row[j], next[j-1])+1);
+                lowest=min(lowest, next[j]);
+            }
+            row.swap(next);
+            if(row[m]<matched){
+                matched=row[m];
+                matches.push_back({node, matched});
+            }
+            if(lowest>=matched || lowest>maxEdits) return;
+        }
+        for(uint32_t child : nodes[node].children){
+            if(nodes[child].best!=empty) fuzzyWalk(child, query, row, maxEdits, matched, matches);
+        }
+    }
+
+    // Best k names under the given subtrees, fewest edits first and then
+    // most popular, opening nodes in that order.
+    vector<Suggestion> topK(const vector<pair<uint32_t, int>>& roots, size_t k) const{
+        struct Candidate{
+            int edits;
+            double score;
+            bool isTerm;
+            uint32_t index;
+        };
+        auto worse=[](const Candidate& a, const Candidate& b){
+            if(a.edits!=b.edits) return a.edits>b.edits;
+            if(a.score!=b.score) return a.score<b.score;
+            return !a.isTerm && b.isTerm;
+        };
+        priority_queue<Candidate, vector<Candidate>, decltype(worse)> frontier(worse);
+        for(const auto& root : roots){
+            if(nodes[root.first].best!=empty) frontier.push({root.second, nodes[root.first].best, false, root.first});
+        }
+        // A name reachable from several roots or keys is reported once, at
+        // its fewest edits.
+        unordered_set<uint32_t> reported;
+        vector<Suggestion> result;
+        while(!frontier.empty() && result.size()<k){
+            Candidate top=frontier.top();
+            frontier.pop();
+            if(top.isTerm){
+                if(!reported.insert(top.index).second) continue;
+                const Term& term=terms[top.index];
+                result.push_back({term.name, term.popularity, top.edits, term.items});
+                continue;
+            }
+            const Node& node=nodes[top.index];
+            for(uint32_t term : node.terms){
+                frontier.push({top.edits, terms[term].popularity, true, term});
+            }
+            for(uint32_t child : node.children){
+                if(nodes[child].best!=empty) frontier.push({top.edits, nodes[child].best, false, child});
+            }
+        }
+        return result;
+    }
+
+public:
+    MenuSearchIndex(){
+        newNode("", none);
+    }
+
+    MenuSearchIndex(const MenuSearchIndex&)=delete;
+    MenuSearchIndex& operator=(const MenuSearchIndex&)=delete;
+
+    // Indexes every menu of restaurants at once, computing the subtree
+    // scores in a single pass at the end.
+    void build(const vector<Restaurant*>& restaurants){
+        unique_lock<shared_mutex> guard(lock);
+        for(const Restaurant* restaurant : restaurants){
+            const MenuCatalog& menu=restaurant->getMenu();
+            for(uint32_t id=0;id<menu.size();id++){
+                string_view name=menu.getName(id);
+                addRef(normalize(name), name, restaurant->getRestaurantId(), menu.getCode(id), false);
+            }
+        }
+        rebuildBest(0);
+    }
+
+    void addItem(int restaurantId, string_view code, string_view name){
+        unique_lock<shared_mutex> guard(lock);
+        addRef(normalize(name), name, restaurantId, code, true);
+    }
+
+    // Forgets one menu item; the name goes once no menu offers it.
+    bool removeItem(int restaurantId, string_view code, string_view name){
+        unique_lock<shared_mutex> guard(lock);
+        auto it=termIds.find(normalize(name));
+        if(it==termIds.end()) return false;
+        uint32_t id=it->second;
+        Term& term=terms[id];
+        auto ref=find_if(term.items.begin(), term.items.end(), [&](const MenuItemRef& r){
+            return r.restaurantId==restaurantId && r.code==code;
+        });
+        if(ref==term.items.end()) return false;
+        term.items.erase(ref);
+        if(term.items.empty()){
+            for(uint32_t node : term.nodes){
+                vector<uint32_t>& here=nodes[node].terms;
+                here.erase(find(here.begin(), here.end(), id));
+                refresh(node);
+            }
+            termIds.erase(it);
+            freeTerms.push_back(id);
+        }
+        return true;
+    }
+
+    void addRestaurant(const Restaurant& restaurant){
+        const MenuCatalog& menu=restaurant.getMenu();
+        for(uint32_t id=0;id<menu.size();id++){
+            addItem(restaurant.getRestaurantId(), menu.getCode(id), menu.getName(id));
+        }
+    }
+
+    void removeRestaurant(const Restaurant& restaurant){
+        const MenuCatalog& menu=restaurant.getMenu();
+        for(uint32_t id=0;id<menu.size();id++){
+            removeItem(restaurant.getRestaurantId(), menu.getCode(id), menu.getName(id));
+        }
+    }
+
+    // Raises the popularity of name, e.g. once per order containing it.
+    void recordOrder(string_view name, double weight=1){
+        unique_lock<shared_mutex> guard(lock);
+        auto it=termIds.find(normalize(name));
+        if(it==termIds.end()) return;
+        Term& term=terms[it->second];
+        term.popularity+=weight;
+        refreshTerm(term);
+    }
+
+    void setPopularity(string_view name, double popularity){
+        unique_lock<shared_mutex> guard(lock);
+        auto it=termIds.find(normalize(name));
+        if(it==termIds.end()) return;
+        Term& term=terms[it->second];
+        term.popularity=popularity;
+        refreshTerm(term);
+    }
+
+    // The k most popular names starting with prefix.
+    vector<Suggestion> complete(string_view prefix, size_t k) const{
+        shared_lock<shared_mutex> guard(lock);
+        uint32_t node=findPrefix(normalize(prefix));
+        if(node==none) return {};
+        return topK({{node, 0}}, k);
+    }
+
+    // Like complete(), but also accepts names whose start is within
+    // maxEdits insertions, deletions or substitutions of prefix. Closer
+    // matches come first, then more popular ones.
+    vector<Suggestion> completeFuzzy(string_view prefix, size_t k, int maxEdits=1) const{
+        shared_lock<shared_mutex> guard(lock);
+        string query=normalize(prefix);
+        vector<int> row(query.size()+1);
+        for(size_t j=0;j<row.size();j++){
+            row[j]=j;
+        }
+        // A query of at most maxEdits characters matches every name.
+        vector<pair<uint32_t, int>> matches;
+        int matched=maxEdits+1;
+        if(row.back()<=maxEdits){
+            matched=row.back();
+            matches.push_back({0, matched});
+        }
+        if(matched>0) fuzzyWalk(0, query, row, maxEdits, matched, matches);
+        return topK(matches, k);
+    }
+
+    size_t size() const{
+        shared_lock<shared_mutex> guard(lock);
+        return termIds.size();
+    }
+};
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef NOTIFICATION_DISPATCHER_H
+#define NOTIFICATION_DISPATCHER_H
+
+#include<iostream>
+#include<string>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<atomic>
+#include<chrono>
+#include "NotificationService.h"
+#include "../models/Order.h"
+#include "../utils/MpscRing.h"
+
+using namespace std;
+
+enum class OverflowPolicy{
+    DROP,   // notify() returns false at once when the queue is full
+    BLOCK   // notify() waits for room
+};
+
+// Sends order notifications from a background thread so placing an order
+// never waits on terminal I/O. notify() fills a record (an OrderNotice and a
+// timestamp: ids, totals and the item lines, about 200 bytes) without
+// allocating for orders of up to eight distinct items, and pushes it into a
+// lock-free ring. The dispatcher thread takes up to maxBatch records at a
+// time, builds their text, reading names through the order's user and
+// restaurant, and writes it with a single flush. The order may change or go
+// away after notify(); its user and restaurant must stay until flush(). Under the BLOCK policy a
+// producer that finds the ring full sleeps until the dispatcher has taken
+// records out.
+class NotificationDispatcher{
+public:
+    struct Stats{
+        size_t enqueued;
+        size_t dropped;
+        size_t dispatched;
+        size_t batches;
+        size_t queueDepth;
+        size_t maxQueueDepth;
+        // From notify() until the batch holding it was flushed.
+        double averageLatencyMicros;
+        double maxLatencyMicros;
+    };
+
+private:
+    using Clock=chrono::steady_clock;
+
+    struct Record{
+        OrderNotice notice;
+        Clock::time_point enqueuedAt;
+    };
+
+    MpscRing<Record> ring;
+    OverflowPolicy policy;
+    ostream& out;
+    size_t maxBatch;
+
+    atomic<size_t> enqueued{0};
+    atomic<size_t> dropped{0};
+    atomic<size_t> dispatched{0};
+    atomic<size_t> batches{0};
+    atomic<size_t> maxQueueDepth{0};
+    atomic<long long> totalLatencyNanos{0};
+    atomic<long long> maxLatencyNanos{0};
+
+    // The dispatcher sleeps here when the ring is empty; producers only take
+    // the mutex when it is actually asleep.
+    mutex sleepLock;
+    condition_variable wake;
+    condition_variable drained;
+    atomic<bool> sleeping{false};
+    atomic<bool> stopping{false};
+    // Producers blocked on a full ring wait here; the dispatcher only takes
+    // the mutex when one of them is.
+    mutex roomLock;
+    condition_variable room;
+    atomic<size_t> blockedProducers{0};
+    thread worker;
+
+    static void raise(atomic<long long>& target, long long value){
+        long long current=target.load(memory_order_relaxed);
+        while(current<value && !target.compare_exchange_weak(current, value, memory_order_relaxed)){}
+    }
+
+    void wakeWorker(){
+        atomic_thread_fence(memory_order_seq_cst);
+        if(sleeping.load(memory_order_relaxed)){
+            lock_guard<mutex> lock(sleepLock);
+            wake.notify_one();
+        }
+    }
+
+    void signalRoom(){
+        atomic_thread_fence(memory_order_seq_cst);
+        if(blockedProducers.load(memory_order_relaxed)>0){
+            lock_guard<mutex> lock(roomLock);
+            room.notify_all();
+        }
+    }
+
+    // BLOCK policy: sleeps until the ring has a free slot.
+    void waitForRoom(){
+        unique_lock<mutex> lock(roomLock);
+        blockedProducers.fetch_add(1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        wakeWorker();
+        room.wait(lock, [&]{ return ring.size()<ring.capacity(); });
+        blockedProducers.fetch_sub(1, memory_order_relaxed);
+    }
+
+    void run(){
+        vector<Record> batch;
+        batch.reserve(maxBatch);
+        string text;
+        while(true){
+            Record record;
+            while(batch.size()<maxBatch && ring.tryPop(record)){
+                batch.push_back(move(record));
+            }
+            if(!batch.empty()) signalRoom();
+            if(batch.empty()){
+                if(stopping.load(memory_order_acquire) && ring.size()==0) break;
+                unique_lock<mutex> lock(sleepLock);
+                sleeping.store(true, memory_order_relaxed);
+                atomic_thread_fence(memory_order_seq_cst);
+                if(ring.size()==0 && !stopping.load(memory_order_relaxed)){
+                    // The timeout only guards against a missed wakeup.
+                    wake.wait_for(lock, chrono::milliseconds(50));
+                }
+                sleeping.store(false, memory_order_relaxed);
+                continue;
+            }
+
+            text.clear();
+            for(const Record& r : batch){
+                NotificationService::format(r.notice, text);
+            }
+            out.write(text.data(), text.size());
+            out.flush();
+
+            Clock::time_point now=Clock::now();
+            for(const Record& r : batch){
+                long long nanos=chrono::duration_cast<chrono::nanoseconds>(now-r.enqueuedAt).count();
+                totalLatencyNanos.fetch_add(nanos, memory_order_relaxed);
+                raise(maxLatencyNanos, nanos);
+            }
+            batches.fetch_add(1, memory_order_relaxed);
+            {
+                lock_guard<mutex> lock(sleepLock);
+                dispatched.fetch_add(batch.size(), memory_order_release);
+            }
+            drained.notify_all();
+            batch.clear();
+        }
+    }
+
+public:
+    NotificationDispatcher(size_t capacity=4096, OverflowPolicy policy=OverflowPolicy::BLOCK,
+                           ostream& out=cout, size_t maxBatch=256)
+        : ring(capacity), out(out){
+        this->policy=policy;
+        this->maxBatch=maxBatch;
+        worker=thread(&NotificationDispatcher::run, this);
+    }
+
+    NotificationDispatcher(const NotificationDispatcher&)=delete;
+    NotificationDispatcher& operator=(const NotificationDispatcher&)=delete;
+
+    // Sends everything still queued, then stops.
+    ~NotificationDispatcher(){
+        stopping.store(true, memory_order_release);
+        {
+            lock_guard<mutex> lock(sleepLock);
+            wake.notify_one();
+        }
+        worker.join();
+    }
+
+    // Queues a notification for order; safe from any thread. Returns false
+    // if it was dropped because the queue was full under the DROP policy.
+    bool notify(const Order& order){
+        Record record={OrderNotice::of(order), Clock::now()};
+        while(!ring.tryPush(record)){
+            if(policy==OverflowPolicy::DROP){
+                dropped.fetch_add(1, memory_order_relaxed);
+                return false;
+            }
+            waitForRoom();
+        }
+        enqueued.fetch_add(1, memory_order_relaxed);
+        size_t depth=ring.size();
+        size_t seen=maxQueueDepth.load(memory_order_relaxed);
+        while(seen<depth && !maxQueueDepth.compare_exchange_weak(seen, depth, memory_order_relaxed)){}
+        wakeWorker();
+        return true;
+    }
+
+    // Blocks until every notification queued before the call is written.
+    void flush(){
+        size_t target=enqueued.load(memory_order_acquire);
+        unique_lock<mutex> lock(sleepLock);
+        drained.wait(lock, [&]{ return dispatched.load(memory_order_acquire)>=target; });
+    }
+
+    Stats stats() const{
+        Stats s;
+        s.enqueued=enqueued.load(memory_order_relaxed);
+        s.dropped=dropped.load(memory_order_relaxed);
+        s.dispatched=dispatched.load(memory_order_relaxed);
+        s.batches=batches.load(memory_order_relaxed);
+        s.queueDepth=ring.size();
+        s.maxQueueDepth=maxQueueDepth.load(memory_order_relaxed);
+        s.averageLatencyMicros=s.dispatched ? totalLatencyNanos.load(memory_order_relaxed)/1e3/s.dispatched : 0;
+        s.maxLatencyMicros=maxLatencyNanos.load(memory_order_relaxed)/1e3;
+        return s;
+    }
+};
+
+#endif
@@ -2,30 +2,101 @@
 #define NOTIFICATION_SERVICE_H
 
 #include<iostream>
+#include<string>
+#include<string_view>
+#include<sstream>
+#include<cstring>
 #include "../models/Order.h"
 
 using namespace std;
 
+// What a notification shows, taken from an order without allocating: ids,
+// numbers and the item lines are copied, and the scheduled label is kept
+// inline (a longer one is shown cut, ending in "..."). The customer's,
+// restaurant's and items' names are read through the user and restaurant
+// when the notice is formatted, so those must outlive it and stay unchanged
+// until then. The order itself may change or go away.
+struct OrderNotice{
+    static constexpr size_t scheduledCapacity=31;
+
+    string_view type;
+    int orderId=0;
+    const User* customer=nullptr;
+    const Restaurant* restaurant=nullptr;
+    CartLines items;
+    double total=0;
+    unsigned char scheduledLength=0;
+    char scheduled[scheduledCapacity];
+
+    static OrderNotice of(const Order& order){
+        OrderNotice notice;
+        notice.type=order.getType();
+        notice.orderId=order.getOrderId();
+        notice.customer=order.getUser();
+        notice.restaurant=order.getRestaurant();
+        notice.items=order.getItems();
+        notice.total=order.getTotal();
+        notice.setScheduled(order.getScheduled());
+        return notice;
+    }
+
+    void setScheduled(string_view label){
+        if(label.size()>scheduledCapacity){
+            size_t keep=scheduledCapacity-3;
+            // Do not cut a UTF-8 character in half.
+            while(keep>0 && (label[keep]&0xc0)==0x80) keep--;
+            memcpy(scheduled, label.data(), keep);
+            memcpy(scheduled+keep, "...", 3);
+            scheduledLength=keep+3;
+        } else {
+            memcpy(scheduled, label.data(), label.size());
+            scheduledLength=label.size();
+        }
+    }
+
+    string_view getScheduled() const{
+        return string_view(scheduled, scheduledLength);
+    }
+};
+
 class NotificationService{
 public:
-    static void notify(Order *order){
-        cout << "\nNotification: New " << order->getType() << " order placed!" << endl;
-        cout << "---------------------------------------------" << endl;
-        cout << "Order ID: " << order->getOrderId() << endl;
-        cout << "Customer: " << order->getUser()->getName() << endl;
-        cout << "Restaurant: " << order->getRestaurant()->getName() << endl;
-        cout << "Items Ordered:\n";
-
-        const vector<MenuItem>& items = order->getItems();
-        for (const auto& item : items) {
-            cout << "   - " << item.getName() << " (₹" << item.getPrice() << ")\n";
+    // Appends the notification text for notice to out.
+    static void format(const OrderNotice& notice, string& out){
+        out+="\nNotification: New ";
+        out+=notice.type;
+        out+=" order placed!\n";
+        out+="---------------------------------------------\n";
+        out+="Order ID: "+to_string(notice.orderId)+"\n";
+        out+="Customer: "+notice.customer->getName()+"\n";
+        out+="Restaurant: "+notice.restaurant->getName()+"\n";
+        out+="Items Ordered:\n";
+
+        const MenuCatalog& menu=notice.restaurant->getMenu();
+        for (const auto& line : notice.items) {
+            out+="   - ";
+            out+=menu.getName(line.itemId);
+            if(line.quantity>1) out+=" x"+to_string(line.quantity);
+            out+=" (₹"+to_string(line.price)+")\n";
         }
 
-        cout << "Total: ₹" << order->getTotal() << endl;
-        cout << "Scheduled For: " << order->getScheduled() << endl;
-        cout << "Payment: Done" << endl;
-        cout << "---------------------------------------------" << endl;
+        ostringstream total;
+        total << notice.total;
+        out+="Total: ₹"+total.str()+"\n";
+        out+="Scheduled For: ";
+        out+=notice.getScheduled();
+        out+="\n";
+        out+="Payment: Done\n";
+        out+="---------------------------------------------\n";
+    }
+
+    // Writes the notification on the calling thread with one flush. Use
+    // NotificationDispatcher to keep terminal I/O off the caller's thread.
+    static void notify(Order *order){
+        string text;
+        format(OrderNotice::of(*order), text);
+        cout << text << flush;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
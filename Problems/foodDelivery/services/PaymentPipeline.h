@@ -0,0 +1,276 @@
+#ifndef PAYMENT_PIPELINE_H
+#define PAYMENT_PIPELINE_H
+
+#include<string>
+#include<vector>
+#include<deque>
+#include<memory>
+#include<functional>
+#include<future>
+#include<unordered_map>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<exception>
+#include<chrono>
+#include "../strategies/PaymentStrategy.h"
+#include "../strategies/PaymentGateway.h"
+
+using namespace std;
+
+// Settles payments through a PaymentGateway in batches, several batches in
+// flight at once. submit() only queues the intent; each of maxInFlight sender
+// threads takes everything queued (up to maxBatch) and sends it in one
+// charge() call, so while one batch waits on the gateway the next one is
+// already filling. Throughput is roughly maxInFlight * maxBatch payments per
+// round trip instead of one.
+//
+// Payments are keyed by their idempotency key. Submitting a key that is in
+// flight or already settled returns the same result without sending it
+// again; a FAILED payment is forgotten so that it can be retried. Reusing a
+// key for a different amount, method or account is DECLINED without being
+// sent. Settled keys are remembered for keepSettledFor, and only the newest
+// maxSettled of them, so the table does not grow forever; a key submitted
+// after it was forgotten is paid again.
+class PaymentPipeline{
+public:
+    using Callback=function<void(const PaymentResult&)>;
+
+    struct Stats{
+        size_t submitted;
+        size_t duplicates;
+        size_t rejected;
+        size_t batches;
+        // APPROVED or DECLINED; FAILED payments are counted apart.
+        size_t settled;
+        size_t failed;
+    };
+
+private:
+    using Clock=chrono::steady_clock;
+
+    struct Payment{
+        PaymentIntent intent;
+        promise<PaymentResult> done;
+        shared_future<PaymentResult> result;
+        vector<Callback> callbacks;
+        bool settled=false;
+    };
+
+    PaymentGateway* gateway;
+    size_t maxBatch;
+    size_t maxSettled;
+    Clock::duration keepSettledFor;
+
+    mutex lock;
+    condition_variable hasWork;
+    condition_variable idle;
+    unordered_map<string, shared_ptr<Payment>> payments;
+    deque<shared_ptr<Payment>> queue;
+    // Settled payments still in payments, oldest first.
+    deque<pair<Clock::time_point, shared_ptr<Payment>>> settledOrder;
+    size_t sending=0;
+    bool stopping=false;
+    vector<thread> senders;
+
+    size_t submitted=0;
+    size_t duplicates=0;
+    size_t rejected=0;
+    size_t batches=0;
+    size_t settledCount=0;
+    size_t failedCount=0;
+
+    static bool samePayment(const PaymentIntent& a, const PaymentIntent& b){
+        return a.amount==b.amount && a.method==b.method && a.account==b.account;
+    }
+
+    // Forgets settled keys past their time or beyond maxSettled; called
+    // with the lock held.
+    void evictSettled(Clock::time_point now){
+        while(!settledOrder.empty() && (settledOrder.size()>maxSettled || now-settledOrder.front().first>keepSettledFor)){
+            const shared_ptr<Payment>& payment=settledOrder.front().second;
+            auto it=payments.find(payment->intent.idempotencyKey);
+            if(it!=payments.end() && it->second==payment) payments.erase(it);
+            settledOrder.pop_front();
+        }
+    }
+
+    static void runCallback(const Callback& callback, const PaymentResult& result){
+        try{
+            callback(result);
+        } catch(...){
+        }
+    }
+
+    void sendLoop(){
+        vector<shared_ptr<Payment>> batch;
+        vector<PaymentIntent> intents;
+        unique_lock<mutex> guard(lock);
+        while(true){
+            hasWork.wait(guard, [&]{ return stopping || !queue.empty(); });
+            if(queue.empty()) return;
+            while(!queue.empty() && batch.size()<maxBatch){
+                batch.push_back(move(queue.front()));
+                queue.pop_front();
+            }
+            sending++;
+            guard.unlock();
+
+            intents.clear();
+            for(const shared_ptr<Payment>& payment : batch){
+                intents.push_back(payment->intent);
+            }
+            vector<PaymentResult> results;
+            string error;
+            try{
+                results=gateway->charge(intents);
+            } catch(const exception& e){
+                error=e.what();
+            } catch(...){
+                error="Gateway threw a non-standard exception";
+            }
+            if(error.empty() && results.size()!=batch.size()) error="Gateway returned "+to_string(results.size())+" results for "+to_string(batch.size())+" payments";
+            if(!error.empty()){
+                results.clear();
+                for(const PaymentIntent& intent : intents){
+                    results.push_back({intent.idempotencyKey, PaymentState::FAILED, "", error});
+                }
+            }
+
+            guard.lock();
+            batches++;
+            vector<vector<Callback>> callbacks(batch.size());
+            Clock::time_point now=Clock::now();
+            for(size_t i=0;i<batch.size();i++){
+                Payment& payment=*batch[i];
+                payment.settled=true;
+                callbacks[i].swap(payment.callbacks);
+                if(results[i].state==PaymentState::FAILED){
+                    payments.erase(payment.intent.idempotencyKey);
+                    failedCount++;
+                } else {
+                    settledOrder.emplace_back(now, batch[i]);
+                    settledCount++;
+                }
+            }
+            evictSettled(now);
+            guard.unlock();
+
+            // Completed outside the lock so callbacks may submit again.
+            // Every result is published before any callback runs, and a
+            // callback that throws is ignored, so one bad callback cannot
+            // stop the thread or leave the rest of the batch waiting.
+            for(size_t i=0;i<batch.size();i++){
+                batch[i]->done.set_value(results[i]);
+            }
+            for(size_t i=0;i<batch.size();i++){
+                for(const Callback& callback : callbacks[i]){
+                    runCallback(callback, results[i]);
+                }
+            }
+            batch.clear();
+
+            guard.lock();
+            sending--;
+            if(queue.empty() && sending==0) idle.notify_all();
+        }
+    }
+
+    shared_ptr<Payment> enqueue(PaymentIntent intent, Callback callback, bool& runNow){
+        lock_guard<mutex> guard(lock);
+        submitted++;
+        runNow=false;
+        evictSettled(Clock::now());
+        auto it=payments.find(intent.idempotencyKey);
+        if(it!=payments.end() && !samePayment(it->second->intent, intent)){
+            rejected++;
+            shared_ptr<Payment> conflict=make_shared<Payment>();
+            conflict->result=conflict->done.get_future().share();
+            conflict->done.set_value({intent.idempotencyKey, PaymentState::DECLINED, "", "Idempotency key already used for a different payment"});
+            conflict->settled=true;
+            runNow=(bool)callback;
+            return conflict;
+        }
+        if(it!=payments.end()){
+            duplicates++;
+            shared_ptr<Payment> payment=it->second;
+            if(callback){
+                if(payment->settled){
+                    runNow=true;
+                } else {
+                    payment->callbacks.push_back(move(callback));
+                }
+            }
+            return payment;
+        }
+        shared_ptr<Payment> payment=make_shared<Payment>();
+        payment->intent=move(intent);
+        payment->result=payment->done.get_future().share();
+        if(callback) payment->callbacks.push_back(move(callback));
+        payments.emplace(payment->intent.idempotencyKey, payment);
+        queue.push_back(payment);
+        hasWork.notify_one();
+        return payment;
+    }
+
+public:
+    PaymentPipeline(PaymentGateway* gateway, size_t maxBatch=64, size_t maxInFlight=4,
+                    size_t maxSettled=100000, Clock::duration keepSettledFor=chrono::hours(24)){
+        this->gateway=gateway;
+        this->maxBatch=maxBatch;
+        this->maxSettled=maxSettled;
+        this->keepSettledFor=keepSettledFor;
+        for(size_t i=0;i<maxInFlight;i++){
+            senders.emplace_back(&PaymentPipeline::sendLoop, this);
+        }
+    }
+
+    PaymentPipeline(const PaymentPipeline&)=delete;
+    PaymentPipeline& operator=(const PaymentPipeline&)=delete;
+
+    // Settles everything already submitted before returning.
+    ~PaymentPipeline(){
+        {
+            lock_guard<mutex> guard(lock);
+            stopping=true;
+        }
+        hasWork.notify_all();
+        for(thread& sender : senders){
+            sender.join();
+        }
+    }
+
+    // Queues intent and returns its eventual result.
+    shared_future<PaymentResult> submit(PaymentIntent intent){
+        bool runNow;
+        return enqueue(move(intent), nullptr, runNow)->result;
+    }
+
+    // Queues intent and calls callback with the result, on a sender thread,
+    // or right away if the key was already settled or is rejected. An
+    // exception thrown by the callback on a sender thread is swallowed; one
+    // thrown when it runs right away reaches the caller.
+    void submit(PaymentIntent intent, Callback callback){
+        bool runNow;
+        shared_ptr<Payment> payment=enqueue(move(intent), callback, runNow);
+        if(runNow) callback(payment->result.get());
+    }
+
+    // Pays amount the way strategy would, through the pipeline.
+    shared_future<PaymentResult> pay(const string& idempotencyKey, const PaymentStrategy& strategy, double amount){
+        return submit({idempotencyKey, strategy.method(), strategy.account(), amount});
+    }
+
+    // Blocks until nothing is queued or being sent.
+    void flush(){
+        unique_lock<mutex> guard(lock);
+        idle.wait(guard, [&]{ return queue.empty() && sending==0; });
+    }
+
+    Stats stats(){
+        lock_guard<mutex> guard(lock);
+        return {submitted, duplicates, rejected, batches, settledCount, failedCount};
+    }
+};
+
+#endif
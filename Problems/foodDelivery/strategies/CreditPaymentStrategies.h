@@ -20,6 +20,14 @@ public:
     void pay(double amount) override{
         cout << "Paid ₹" << amount << " using Credit Card (" << cardNumber << ")" << endl;
     }
+
+    string method() const override{
+        return "card";
+    }
+
+    string account() const override{
+        return cardNumber;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef MOCK_PAYMENT_GATEWAY_H
+#define MOCK_PAYMENT_GATEWAY_H
+
+#include<string>
+#include<vector>
+#include<unordered_map>
+#include<mutex>
+#include<thread>
+#include<chrono>
+#include<atomic>
+#include "PaymentGateway.h"
+using namespace std;
+
+// In-process stand-in for a payment gateway, for tests and demos. Every
+// charge() call sleeps for the configured round-trip latency plus a small
+// cost per intent, approves amounts up to declineAbove and remembers each
+// key, so a repeated key gets its first result back instead of a second
+// charge.
+class MockPaymentGateway: public PaymentGateway{
+private:
+    chrono::microseconds roundTrip;
+    chrono::microseconds perIntent;
+    double declineAbove;
+
+    mutex lock;
+    unordered_map<string, PaymentResult> processed;
+    size_t nextReference=0;
+    atomic<size_t> calls{0};
+    atomic<size_t> charges{0};
+
+public:
+    MockPaymentGateway(chrono::microseconds roundTrip=chrono::milliseconds(20),
+                       chrono::microseconds perIntent=chrono::microseconds(0),
+                       double declineAbove=100000){
+        this->roundTrip=roundTrip;
+        this->perIntent=perIntent;
+        this->declineAbove=declineAbove;
+    }
+
+    vector<PaymentResult> charge(const vector<PaymentIntent>& batch) override{
+        calls.fetch_add(1, memory_order_relaxed);
+        this_thread::sleep_for(roundTrip+perIntent*batch.size());
+
+        vector<PaymentResult> results;
+        results.reserve(batch.size());
+        lock_guard<mutex> guard(lock);
+        for(const PaymentIntent& intent : batch){
+            auto it=processed.find(intent.idempotencyKey);
+            if(it==processed.end()){
+                PaymentResult result={intent.idempotencyKey, PaymentState::APPROVED, "", ""};
+                if(intent.amount>declineAbove){
+                    result.state=PaymentState::DECLINED;
+                    result.message="Amount over limit";
+                } else {
+                    result.reference="TXN"+to_string(++nextReference);
+                    charges.fetch_add(1, memory_order_relaxed);
+                }
+                it=processed.emplace(intent.idempotencyKey, result).first;
+            }
+            results.push_back(it->second);
+        }
+        return results;
+    }
+
+    // Number of charge() calls, i.e. round trips.
+    size_t roundTrips() const{
+        return calls.load(memory_order_relaxed);
+    }
+
+    // Number of payments actually approved.
+    size_t approvedCharges() const{
+        return charges.load(memory_order_relaxed);
+    }
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef PAYMENT_GATEWAY_H
+#define PAYMENT_GATEWAY_H
+
+#include<string>
+#include<vector>
+using namespace std;
+
+// One payment to be made. The idempotency key names the payment, not the
+// attempt: sending the same key again must never charge twice.
+struct PaymentIntent{
+    string idempotencyKey;
+    string method;   // "card", "upi", ...
+    string account;  // card number, mobile number, ...
+    double amount;
+};
+
+enum class PaymentState{
+    APPROVED,
+    DECLINED,   // the gateway said no; retrying will not help
+    FAILED      // the payment may not have reached the gateway; safe to retry
+};
+
+struct PaymentResult{
+    string idempotencyKey;
+    PaymentState state;
+    string reference;
+    string message;
+};
+
+// Remote payment processor. charge() is one round trip for a whole batch
+// and may be called from several threads at once.
+class PaymentGateway{
+public:
+    // Returns one result per intent, in the same order.
+    virtual vector<PaymentResult> charge(const vector<PaymentIntent>& batch) = 0;
+    virtual ~PaymentGateway(){};
+};
+
+#endif
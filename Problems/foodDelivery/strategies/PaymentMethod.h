@@ -0,0 +1,95 @@
+#ifndef PAYMENT_METHOD_H
+#define PAYMENT_METHOD_H
+
+#include<iostream>
+#include<string_view>
+#include<variant>
+#include<cstring>
+#include<stdexcept>
+using namespace std;
+
+// Statically dispatched counterparts of CreditPaymentStrategy and
+// UpiPaymentStrategy. A PaymentMethod is a variant held by value, so choosing
+// a method allocates nothing and paying is a switch on the variant's index
+// that the compiler can inline; PaymentStrategy stays for methods added as
+// plug-ins.
+
+// Account number stored inline, up to capacity characters; a longer one is
+// rejected rather than cut, since a cut number would pay the wrong account.
+class AccountNumber{
+private:
+    static constexpr size_t capacity=31;
+    char digits[capacity+1];
+    unsigned char length;
+
+public:
+    AccountNumber(string_view number){
+        if(number.size()>capacity){
+            throw invalid_argument("AccountNumber: longer than "+to_string(capacity)+" characters");
+        }
+        length=number.size();
+        memcpy(digits, number.data(), length);
+        digits[length]='\0';
+    }
+
+    string_view view() const{
+        return string_view(digits, length);
+    }
+};
+
+class CreditPayment{
+private:
+    AccountNumber cardNumber;
+
+public:
+    explicit CreditPayment(string_view card): cardNumber(card){}
+
+    void pay(double amount, ostream& out=cout) const{
+        out << "Paid ₹" << amount << " using Credit Card (" << cardNumber.view() << ")\n";
+    }
+
+    string_view method() const{
+        return "card";
+    }
+
+    string_view account() const{
+        return cardNumber.view();
+    }
+};
+
+class UpiPayment{
+private:
+    AccountNumber mobile;
+
+public:
+    explicit UpiPayment(string_view mob): mobile(mob){}
+
+    void pay(double amount, ostream& out=cout) const{
+        out << " Paid ₹ " << amount << " using UPI (" << mobile.view() << ")\n";
+    }
+
+    string_view method() const{
+        return "upi";
+    }
+
+    string_view account() const{
+        return mobile.view();
+    }
+};
+
+// monostate means no method chosen yet.
+using PaymentMethod=variant<monostate, CreditPayment, UpiPayment>;
+
+// Returns false if no method was chosen.
+inline bool pay(const PaymentMethod& method, double amount, ostream& out=cout){
+    if(const CreditPayment* card=get_if<CreditPayment>(&method)){
+        card->pay(amount, out);
+    } else if(const UpiPayment* upi=get_if<UpiPayment>(&method)){
+        upi->pay(amount, out);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+#endif
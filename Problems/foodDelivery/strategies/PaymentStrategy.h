@@ -8,6 +8,9 @@ using namespace std;
 class PaymentStrategy{
 public:
     virtual void pay(double amount) = 0;
+    // How PaymentPipeline describes this strategy to a gateway.
+    virtual string method() const{ return "other"; }
+    virtual string account() const{ return ""; }
     virtual ~PaymentStrategy(){};
 };
 
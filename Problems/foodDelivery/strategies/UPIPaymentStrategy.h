@@ -19,6 +19,14 @@ public:
     void pay(double amount) override{
         cout<<" Paid ₹ "<<amount<< " using UPI ("<<mobile<< ")"<<endl;
     }
+
+    string method() const override{
+        return "upi";
+    }
+
+    string account() const override{
+        return mobile;
+    }
 };
 
 #endif
\ No newline at end of file
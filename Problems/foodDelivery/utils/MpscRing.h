@@ -0,0 +1,87 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include<atomic>
+#include<memory>
+#include<cstddef>
+#include<cstdint>
+using namespace std;
+
+// Bounded lock-free queue for many producers and one consumer. Every cell
+// carries a sequence number telling whose turn it is: producers claim a
+// position with one compare-and-swap on tail and publish the value by
+// bumping the cell's sequence; the consumer reads cells in order and hands
+// them back the same way. Capacity is rounded up to a power of two.
+template<typename T>
+class MpscRing{
+private:
+    struct Cell{
+        atomic<size_t> sequence;
+        T value;
+    };
+
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> tail{0};
+    // Written only by the consumer; atomic so size() can read it.
+    alignas(64) atomic<size_t> head{0};
+
+public:
+    explicit MpscRing(size_t capacity){
+        size_t size=2;
+        while(size<capacity) size*=2;
+        cells.reset(new Cell[size]);
+        mask=size-1;
+        for(size_t i=0;i<size;i++){
+            cells[i].sequence.store(i, memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&)=delete;
+    MpscRing& operator=(const MpscRing&)=delete;
+
+    // Any thread. Returns false, leaving value alone, if the ring is full.
+    bool tryPush(T& value){
+        size_t pos=tail.load(memory_order_relaxed);
+        while(true){
+            Cell& cell=cells[pos&mask];
+            size_t sequence=cell.sequence.load(memory_order_acquire);
+            intptr_t lag=(intptr_t)sequence-(intptr_t)pos;
+            if(lag==0){
+                if(tail.compare_exchange_weak(pos, pos+1, memory_order_relaxed)){
+                    cell.value=move(value);
+                    cell.sequence.store(pos+1, memory_order_release);
+                    return true;
+                }
+            } else if(lag<0){
+                return false;
+            } else {
+                pos=tail.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only. Returns false if the ring is empty.
+    bool tryPop(T& value){
+        size_t pos=head.load(memory_order_relaxed);
+        Cell& cell=cells[pos&mask];
+        if(cell.sequence.load(memory_order_acquire)!=pos+1) return false;
+        value=move(cell.value);
+        cell.sequence.store(pos+mask+1, memory_order_release);
+        head.store(pos+1, memory_order_relaxed);
+        return true;
+    }
+
+    // Approximate number of queued values.
+    size_t size() const{
+        size_t t=tail.load(memory_order_relaxed);
+        size_t h=head.load(memory_order_relaxed);
+        return t>h ? t-h : 0;
+    }
+
+    size_t capacity() const{
+        return mask+1;
+    }
+};
+
+#endif
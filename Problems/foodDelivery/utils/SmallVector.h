@@ -0,0 +1,205 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include<memory>
+#include<new>
+#include<utility>
+#include<initializer_list>
+#include<cstddef>
+using namespace std;
+
+// Vector that keeps its first N elements inside the object itself and only
+// moves them to the heap when it grows past N, so a container of a few
+// elements costs no allocation at all. Elements stay in insertion order.
+template<typename T, size_t N>
+class SmallVector{
+private:
+    alignas(T) unsigned char inlineStorage[N*sizeof(T)];
+    T* data_;
+    size_t size_=0;
+    size_t capacity_=N;
+
+    T* inlineData(){
+        return reinterpret_cast<T*>(inlineStorage);
+    }
+
+    bool isInline() const{
+        return data_==reinterpret_cast<const T*>(inlineStorage);
+    }
+
+    void grow(size_t needed){
+        size_t capacity=capacity_*2;
+        if(capacity<needed) capacity=needed;
+        T* bigger=static_cast<T*>(::operator new(capacity*sizeof(T)));
+        for(size_t i=0;i<size_;i++){
+            new (bigger+i) T(move(data_[i]));
+            data_[i].~T();
+        }
+        if(!isInline()) ::operator delete(data_);
+        data_=bigger;
+        capacity_=capacity;
+    }
+
+    // Leaves this empty and inline.
+    void reset(){
+        clear();
+        if(!isInline()) ::operator delete(data_);
+        data_=inlineData();
+        capacity_=N;
+    }
+
+    void moveFrom(SmallVector& other){
+        if(other.isInline()){
+            for(size_t i=0;i<other.size_;i++){
+                new (data_+i) T(move(other.data_[i]));
+            }
+            size_=other.size_;
+            other.clear();
+        } else {
+            // Take over the heap buffer.
+            data_=other.data_;
+            size_=other.size_;
+            capacity_=other.capacity_;
+            other.data_=other.inlineData();
+            other.size_=0;
+            other.capacity_=N;
+        }
+    }
+
+public:
+    SmallVector(): data_(inlineData()){}
+
+    SmallVector(initializer_list<T> values): data_(inlineData()){
+        reserve(values.size());
+        for(const T& value : values){
+            push_back(value);
+        }
+    }
+
+    SmallVector(const SmallVector& other): data_(inlineData()){
+        reserve(other.size_);
+        for(const T& value : other){
+            push_back(value);
+        }
+    }
+
+    SmallVector(SmallVector&& other) noexcept: data_(inlineData()){
+        moveFrom(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other){
+        if(this!=&other){
+            clear();
+            reserve(other.size_);
+            for(const T& value : other){
+                push_back(value);
+            }
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept{
+        if(this!=&other){
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector(){
+        reset();
+    }
+
+    void push_back(const T& value){
+        emplace_back(value);
+    }
+
+    void push_back(T&& value){
+        emplace_back(move(value));
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args){
+        if(size_==capacity_){
+            // Build first: args may refer to an element that grow() moves.
+            T value(forward<Args>(args)...);
+            grow(size_+1);
+            return *new (data_+size_++) T(move(value));
+        }
+        return *new (data_+size_++) T(forward<Args>(args)...);
+    }
+
+    // Removes the element at index, keeping the others in order.
+    void erase(size_t index){
+        for(size_t i=index;i+1<size_;i++){
+            data_[i]=move(data_[i+1]);
+        }
+        data_[--size_].~T();
+    }
+
+    void pop_back(){
+        data_[--size_].~T();
+    }
+
+    void clear(){
+        for(size_t i=0;i<size_;i++){
+            data_[i].~T();
+        }
+        size_=0;
+    }
+
+    void reserve(size_t capacity){
+        if(capacity>capacity_) grow(capacity);
+    }
+
+    size_t size() const{
+        return size_;
+    }
+
+    size_t capacity() const{
+        return capacity_;
+    }
+
+    bool empty() const{
+        return size_==0;
+    }
+
+    // Whether the elements are still stored inside the object.
+    bool inlined() const{
+        return isInline();
+    }
+
+    T& operator[](size_t index){
+        return data_[index];
+    }
+
+    const T& operator[](size_t index) const{
+        return data_[index];
+    }
+
+    T& back(){
+        return data_[size_-1];
+    }
+
+    const T& back() const{
+        return data_[size_-1];
+    }
+
+    T* begin(){
+        return data_;
+    }
+
+    T* end(){
+        return data_+size_;
+    }
+
+    const T* begin() const{
+        return data_;
+    }
+
+    const T* end() const{
+        return data_+size_;
+    }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef TIME_UTILS_H
+#define TIME_UTILS_H
+
+#include<atomic>
+#include<chrono>
+#include<cstdint>
+using namespace std;
+
+// Source of the current time in milliseconds. Code that waits on time takes
+// a Clock so tests can swap in a ManualClock and move time forward at once.
+class Clock{
+public:
+    virtual int64_t nowMillis() const = 0;
+    virtual ~Clock(){};
+};
+
+// Monotonic wall time.
+class SystemClock: public Clock{
+public:
+    int64_t nowMillis() const override{
+        return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Time that only moves when told to.
+class ManualClock: public Clock{
+private:
+    atomic<int64_t> now;
+
+public:
+    ManualClock(int64_t start=0): now(start){}
+
+    int64_t nowMillis() const override{
+        return now.load(memory_order_acquire);
+    }
+
+    void advance(int64_t millis){
+        now.fetch_add(millis, memory_order_acq_rel);
+    }
+
+    void set(int64_t millis){
+        now.store(millis, memory_order_release);
+    }
+};
+
+#endif
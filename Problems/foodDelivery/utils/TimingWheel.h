@@ -0,0 +1,226 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include<vector>
+#include<cstdint>
+#include<utility>
+#include<algorithm>
+using namespace std;
+
+// Hierarchical timing wheel holding values until a due time (in ticks, e.g.
+// milliseconds, at or after zero). Level L has 256 buckets, each 256^L ticks
+// wide, so eight levels reach any 64-bit time. A timer sits in the level
+// that first tells its due time apart from now, and falls down a level when
+// its bucket comes round, until it lands in level 0 and fires.
+//
+// Buckets are intrusive doubly-linked lists over one pool of entries, so
+// schedule() and cancel() are O(1). A bitmap per level marks the buckets that
+// hold anything, so advance() jumps straight to the next bucket due instead
+// of stepping through empty ticks, and nextDue() is a few word scans.
+//
+// Not thread-safe.
+template<typename T>
+class TimingWheel{
+public:
+    // Names one scheduled timer; stays invalid once it fires or is cancelled.
+    using TimerId=uint64_t;
+
+private:
+    static const int levelBits=8;
+    static const int levels=8;
+    static const uint32_t slots=1<<levelBits;
+    static constexpr uint32_t none=UINT32_MAX;
+
+    struct Entry{
+        T value;
+        int64_t due;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t generation;
+        uint32_t bucket;  // level*slots+slot, or none while free
+    };
+
+    vector<Entry> entries;
+    uint32_t freeList=none;
+    uint32_t heads[levels*slots];
+    uint64_t occupied[levels][slots/64]={};
+    int64_t current;
+    size_t count=0;
+
+    static TimerId makeId(uint32_t index, uint32_t generation){
+        return (uint64_t)generation<<32 | index;
+    }
+
+    void link(uint32_t index){
+        Entry& entry=entries[index];
+        // The level of the highest bit where due and now differ, so every
+        // timer in a level shares its bucket group with now and each bucket
+        // holds a single block of time.
+        uint64_t differ=(uint64_t)entry.due^(uint64_t)current;
+        int level=differ<slots ? 0 : (63-__builtin_clzll(differ))/levelBits;
+        uint32_t slot=(uint64_t)entry.due>>(level*levelBits)&(slots-1);
+        uint32_t bucket=level*slots+slot;
+        entry.bucket=bucket;
+        entry.prev=none;
+        entry.next=heads[bucket];
+        if(entry.next!=none) entries[entry.next].prev=index;
+        heads[bucket]=index;
+        occupied[level][slot/64]|=uint64_t(1)<<(slot%64);
+    }
+
+    void unlink(uint32_t index){
+        Entry& entry=entries[index];
+        if(entry.prev!=none){
+            entries[entry.prev].next=entry.next;
+        } else {
+            heads[entry.bucket]=entry.next;
+        }
+        if(entry.next!=none) entries[entry.next].prev=entry.prev;
+        if(heads[entry.bucket]==none){
+            uint32_t slot=entry.bucket%slots;
+            occupied[entry.bucket/slots][slot/64]&=~(uint64_t(1)<<(slot%64));
+        }
+    }
+
+    // Detaches the whole bucket and returns its first entry.
+    uint32_t takeBucket(int level, uint32_t slot){
+        uint32_t first=heads[level*slots+slot];
+        heads[level*slots+slot]=none;
+        occupied[level][slot/64]&=~(uint64_t(1)<<(slot%64));
+        return first;
+    }
+
+    void release(uint32_t index){
+        Entry& entry=entries[index];
+        entry.value=T();
+        entry.generation++;
+        entry.bucket=none;
+        entry.next=freeList;
+        freeList=index;
+        count--;
+    }
+
+    // First occupied slot of level at or after from, going round once.
+    int nextSlot(int level, uint32_t from) const{
+        for(uint32_t step=0;step<=slots/64;step++){
+            uint32_t word=(from/64+step)%(slots/64);
+            uint64_t bits=occupied[level][word];
+            if(step==0) bits&=~uint64_t(0)<<(from%64);
+            if(step==slots/64) bits&=~(~uint64_t(0)<<(from%64));
+            if(bits) return word*64+__builtin_ctzll(bits);
+        }
+        return -1;
+    }
+
+    // Time at which the first occupied bucket of level must be handled:
+    // fired for level 0, moved down a level for the others.
+    int64_t bucketTime(int level) const{
+        int shift=level*levelBits;
+        uint64_t base=(uint64_t)current>>shift;
+        int slot=nextSlot(level, base&(slots-1));
+        if(slot<0) return INT64_MAX;
+        uint64_t block=base+((slot-base)&(slots-1));
+        return (int64_t)(block<<shift);
+    }
+
+public:
+    explicit TimingWheel(int64_t now=0){
+        current=now;
+        for(uint32_t& head : heads) head=none;
+    }
+
+    // Schedules value to fire at due; a time already past fires on the next
+    // advance().
+    TimerId schedule(int64_t due, T value){
+        uint32_t index;
+        if(freeList!=none){
+            index=freeList;
+            freeList=entries[index].next;
+        } else {
+            index=entries.size();
+            entries.push_back(Entry{T(), 0, none, none, 0, none});
+        }
+        Entry& entry=entries[index];
+        entry.value=move(value);
+        entry.due=due<current ? current : due;
+        link(index);
+        count++;
+        return makeId(index, entry.generation);
+    }
+
+    // Returns false if id already fired or was cancelled.
+    bool cancel(TimerId id){
+        uint32_t index=(uint32_t)id;
+        if(index>=entries.size()) return false;
+        Entry& entry=entries[index];
+        if(entry.bucket==none || entry.generation!=(uint32_t)(id>>32)) return false;
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    // Moves time forward to now and calls fire(value) for every timer due by
+    // then, in due order. fire may schedule or cancel other timers.
+    template<typename F>
+    size_t advance(int64_t now, F fire){
+        size_t fired=0;
+        while(true){
+            int64_t next=nextDue();
+            if(next>now){
+                if(now>current) current=now;
+                return fired;
+            }
+            current=next;
+
+            // Buckets starting now move down, coarsest first, so everything
+            // due at this tick ends up in level 0.
+            for(int level=levels-1;level>0;level--){
+                int shift=level*levelBits;
+                if(current&((int64_t(1)<<shift)-1)) continue;
+                uint32_t index=takeBucket(level, ((uint64_t)current>>shift)&(slots-1));
+                while(index!=none){
+                    uint32_t following=entries[index].next;
+                    link(index);
+                    index=following;
+                }
+            }
+
+            // Taken one at a time so fire can cancel the rest or add more.
+            uint32_t& head=heads[current&(slots-1)];
+            while(head!=none){
+                uint32_t index=head;
+                unlink(index);
+                T value=move(entries[index].value);
+                release(index);
+                fire(value);
+                fired++;
+            }
+        }
+    }
+
+    // Earliest time advance() has anything to do, or INT64_MAX when empty.
+    // A timer in a coarse level reports the start of its bucket, which may be
+    // before its due time, so a caller sleeping until nextDue() never
+    // oversleeps.
+    int64_t nextDue() const{
+        int64_t next=INT64_MAX;
+        for(int level=0;level<levels;level++){
+            next=min(next, bucketTime(level));
+        }
+        return next;
+    }
+
+    int64_t now() const{
+        return current;
+    }
+
+    size_t size() const{
+        return count;
+    }
+
+    void reserve(size_t capacity){
+        entries.reserve(capacity);
+    }
+};
+
+#endif
@@ -0,0 +1,101 @@
+// Compression ratio of CompressedFileStorage against its save and load
+// throughput, next to plain FileStorage, on about 100 MB of prose-like text.
+// Also times reading a 4 KB region, which decodes only the blocks it spans.
+//
+//   g++ -std=c++17 -O2 -pthread compression.cpp -o compression && ./compression
+
+#include<iostream>
+#include<iomanip>
+#include<fstream>
+#include<sstream>
+#include<string>
+#include<chrono>
+#include<random>
+#include<algorithm>
+#include<sys/stat.h>
+#include "../models/Document.h"
+#include "../storage/FileStorage.h"
+#include "../storage/CompressedFileStorage.h"
+
+using namespace std;
+
+template<typename F>
+double bestMillis(int runs, F fn){
+    double best=1e300;
+    for(int i=0;i<runs;i++){
+        auto start=chrono::steady_clock::now();
+        fn();
+        best=min(best, chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+    }
+    return best;
+}
+
+size_t fileSize(const string& path){
+    struct stat info;
+    return ::stat(path.c_str(), &info)==0 ? info.st_size : 0;
+}
+
+int main(){
+    const size_t targetBytes=100*1000*1000;
+    const char* words[]={"the", "document", "editor", "renders", "each", "element", "into", "a",
+                         "sink", "and", "saves", "blocks", "of", "text", "with", "images"};
+    mt19937 rng(42);
+
+    Document doc;
+    while(doc.renderedLength()<targetBytes){
+        string line;
+        size_t count=5+rng()%15;
+        for(size_t i=0;i<count;i++){
+            if(i>0) line+=' ';
+            line+=words[rng()%16];
+        }
+        doc.addElement(doc.arena().makeText(line));
+        doc.addElement(doc.arena().makeNewLine());
+    }
+    double megabytes=doc.renderedLength()/1e6;
+    auto snapshot=doc.snapshot();
+    cout << megabytes << " MB" << endl;
+
+    // Keep the storages' progress messages out of the table.
+    ostringstream quiet;
+    streambuf* console=cout.rdbuf(quiet.rdbuf());
+
+    FileStorage plain("bench_plain.txt");
+    CompressedFileStorage packed("bench_packed.lz");
+    double plainSave=bestMillis(3, [&]{ plain.saveDocument(*snapshot); });
+    double packedSave=bestMillis(3, [&]{ packed.saveDocument(*snapshot); });
+
+    volatile size_t sink=0;
+    double plainLoad=bestMillis(3, [&]{
+        ifstream in("bench_plain.txt", ios::binary);
+        ostringstream text;
+        text << in.rdbuf();
+        sink=sink+text.str().size();
+    });
+    string text;
+    double packedLoad=bestMillis(3, [&]{ packed.load(text); });
+
+    const int regionReads=1000;
+    double regions=bestMillis(1, [&]{
+        for(int i=0;i<regionReads;i++){
+            packed.read(rng()%doc.renderedLength(), 4096, text);
+            sink=sink+text.size();
+        }
+    });
+    cout.rdbuf(console);
+
+    size_t plainBytes=fileSize("bench_plain.txt");
+    size_t packedBytes=fileSize("bench_packed.lz");
+    cout << fixed << setprecision(2);
+    cout << setw(12) << "" << setw(12) << "MB" << setw(14) << "save MB/s" << setw(14) << "load MB/s" << endl;
+    cout << setw(12) << "plain" << setw(12) << plainBytes/1e6
+         << setw(14) << megabytes/(plainSave/1000) << setw(14) << megabytes/(plainLoad/1000) << endl;
+    cout << setw(12) << "compressed" << setw(12) << packedBytes/1e6
+         << setw(14) << megabytes/(packedSave/1000) << setw(14) << megabytes/(packedLoad/1000) << endl;
+    cout << "ratio " << (double)plainBytes/packedBytes << ":1, 4 KB region read "
+         << regions*1000/regionReads << " us" << endl;
+
+    ::unlink("bench_plain.txt");
+    ::unlink("bench_packed.lz");
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Render throughput of the DocumentElement hierarchy against FlatDocument,
+// on documents from 10^3 to 10^7 elements.
+//
+//   g++ -std=c++17 -O2 flat_vs_virtual.cpp -o flat_vs_virtual && ./flat_vs_virtual
+//
+// Columns:
+//   temp-strings  the basic/good.cpp loop: result += element->render()
+//   virtual       Document::render(), virtual renderTo() into one string
+//   flat          FlatDocument::render(), tag switch into one string
+
+#include<iostream>
+#include<iomanip>
+#include<string>
+#include<chrono>
+#include<algorithm>
+#include "../models/Document.h"
+#include "../models/FlatDocument.h"
+
+using namespace std;
+
+template<typename F>
+double bestMillis(int runs, F fn){
+    double best=1e300;
+    for(int i=0;i<runs;i++){
+        auto start=chrono::steady_clock::now();
+        fn();
+        best=min(best, chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+    }
+    return best;
+}
+
+// Same mix for both stores: text, text, new line, text, image, new line.
+template<typename AddText, typename AddImage, typename AddNewLine>
+void build(size_t elements, AddText addText, AddImage addImage, AddNewLine addNewLine){
+    static const string words[]={"The quick brown fox ", "jumps over the lazy dog. ", "Lorem ipsum dolor sit amet, "};
+    for(size_t i=0;i<elements;i++){
+        switch(i%6){
+        case 0: case 1: case 3: addText(words[i%3]); break;
+        case 4: addImage("figure.png"); break;
+        default: addNewLine(); break;
+        }
+    }
+}
+
+void run(size_t elements){
+    int runs=elements<=100000 ? 20 : 3;
+    volatile size_t sink=0;
+
+    double temp, virt, flat;
+    size_t bytes;
+    {
+        Document doc;
+        build(elements,
+              [&](const string& t){ doc.addElement(doc.arena().makeText(t)); },
+              [&](const string& p){ doc.addElement(doc.arena().makeImage(p)); },
+              [&]{ doc.addElement(doc.arena().makeNewLine()); });
+        bytes=doc.renderedLength();
+        temp=bestMillis(runs, [&]{
+            string result;
+            doc.forEach([&](DocumentElement* element){
+                result += element->render();
+            });
+            sink=sink+result.size();
+        });
+        virt=bestMillis(runs, [&]{ sink=sink+doc.render().size(); });
+    }
+    {
+        FlatDocument doc;
+        build(elements,
+              [&](const string& t){ doc.addText(t); },
+              [&](const string& p){ doc.addImage(p); },
+              [&]{ doc.addNewLine(); });
+        flat=bestMillis(runs, [&]{ sink=sink+doc.render().size(); });
+    }
+
+    auto mbps=[&](double ms){ return bytes/1e6/(ms/1000); };
+    cout << setw(10) << elements
+         << setw(12) << bytes/1000000.0
+         << setw(16) << temp << setw(10) << mbps(temp)
+         << setw(12) << virt << setw(10) << mbps(virt)
+         << setw(12) << flat << setw(10) << mbps(flat) << endl;
+}
+
+int main(){
+    cout << fixed << setprecision(2);
+    cout << setw(10) << "elements" << setw(12) << "MB"
+         << setw(16) << "temp-strings ms" << setw(10) << "MB/s"
+         << setw(12) << "virtual ms" << setw(10) << "MB/s"
+         << setw(12) << "flat ms" << setw(10) << "MB/s" << endl;
+    for(size_t elements=1000; elements<=10000000; elements*=10){
+        run(elements);
+    }
+    return 0;
+}
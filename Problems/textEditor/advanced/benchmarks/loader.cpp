@@ -0,0 +1,88 @@
+// Opening a large file with DocumentLoader: load time and the resident memory
+// it costs, then the first line count, which is when the mapped text is first
+// read. Loading must not touch the mapped pages, so the program fails if the
+// load takes longer than maxLoadMillis or grows RSS by more than maxLoadRss.
+//
+//   g++ -std=c++17 -O2 -pthread loader.cpp -o loader && ./loader [megabytes]
+
+#include<iostream>
+#include<iomanip>
+#include<fstream>
+#include<sstream>
+#include<string>
+#include<chrono>
+#include<cstdlib>
+#include<cstdio>
+#include<algorithm>
+#include "../models/Document.h"
+#include "../storage/DocumentLoader.h"
+
+using namespace std;
+
+// Resident set size of this process in bytes, from /proc/self/statm.
+size_t residentBytes(){
+    ifstream statm("/proc/self/statm");
+    size_t pages=0, resident=0;
+    statm >> pages >> resident;
+    return resident*4096;
+}
+
+double millisSince(chrono::steady_clock::time_point start){
+    return chrono::duration<double, milli>(chrono::steady_clock::now()-start).count();
+}
+
+int main(int argc, char** argv){
+    const double maxLoadMillis=100;
+    const size_t maxLoadRss=32<<20;
+    size_t megabytes=argc>1 ? atoi(argv[1]) : 800;
+    const string path="bench_load.txt";
+
+    string block;
+    while(block.size()<(1<<20)) block+="the loader maps the file and cuts it into borrowed blocks\n";
+    block.resize(1<<20);
+    {
+        ofstream out(path, ios::binary);
+        for(size_t i=0;i<megabytes;i++){
+            out.write(block.data(), block.size());
+        }
+    }
+
+    Document doc;
+    size_t rssBefore=residentBytes();
+    auto start=chrono::steady_clock::now();
+    // Keep the loader's messages out of the table.
+    ostringstream quiet;
+    streambuf* console=cout.rdbuf(quiet.rdbuf());
+    bool loaded=DocumentLoader::load(path, doc);
+    cout.rdbuf(console);
+    double loadMillis=millisSince(start);
+    size_t loadRss=residentBytes()-rssBefore;
+
+    start=chrono::steady_clock::now();
+    size_t lines=doc.lineCount();
+    double countMillis=millisSince(start);
+    size_t countRss=residentBytes()-rssBefore;
+
+    start=chrono::steady_clock::now();
+    size_t again=doc.lineCount();
+    double recountMillis=millisSince(start);
+
+    cout << fixed << setprecision(1);
+    cout << megabytes << " MB in " << doc.size() << " elements" << endl;
+    cout << left << setw(20) << "step" << right << setw(12) << "ms" << setw(14) << "RSS MB" << endl;
+    cout << left << setw(20) << "load" << right << setw(12) << loadMillis << setw(14) << loadRss/1e6 << endl;
+    cout << left << setw(20) << "first lineCount" << right << setw(12) << countMillis << setw(14) << countRss/1e6 << endl;
+    cout << left << setw(20) << "second lineCount" << right << setw(12) << recountMillis << setw(14) << "" << endl;
+    remove(path.c_str());
+
+    if(!loaded || lines!=again || lines!=megabytes*count(block.begin(), block.end(), '\n')+1){
+        cout << "FAIL: wrong document" << endl;
+        return 1;
+    }
+    if(loadMillis>maxLoadMillis || loadRss>maxLoadRss){
+        cout << "FAIL: load read the file (limits " << maxLoadMillis << " ms, " << (maxLoadRss>>20) << " MB)" << endl;
+        return 1;
+    }
+    cout << "ok" << endl;
+    return 0;
+}
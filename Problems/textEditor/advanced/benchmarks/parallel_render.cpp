@@ -0,0 +1,54 @@
+// Render throughput of Document::renderParallel() by thread count on a
+// document of about 200 MB.
+//
+//   g++ -std=c++17 -O2 -pthread parallel_render.cpp -o parallel_render && ./parallel_render
+
+#include<iostream>
+#include<iomanip>
+#include<string>
+#include<chrono>
+#include<thread>
+#include<algorithm>
+#include "../models/Document.h"
+
+using namespace std;
+
+template<typename F>
+double bestMillis(int runs, F fn){
+    double best=1e300;
+    for(int i=0;i<runs;i++){
+        auto start=chrono::steady_clock::now();
+        fn();
+        best=min(best, chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+    }
+    return best;
+}
+
+int main(){
+    const size_t targetBytes=200*1000*1000;
+    const string paragraph(120, 'x');
+
+    Document doc;
+    while(doc.renderedLength()<targetBytes){
+        doc.addElement(doc.arena().makeText(paragraph));
+        doc.addElement(doc.arena().makeNewLine());
+        if(doc.size()%100==0) doc.addElement(doc.arena().makeImage("figure.png"));
+    }
+    double megabytes=doc.renderedLength()/1e6;
+    cout << doc.size() << " elements, " << megabytes << " MB" << endl;
+    cout << fixed << setprecision(2);
+
+    volatile size_t sink=0;
+    double sequential=bestMillis(3, [&]{ sink=sink+doc.render().size(); });
+    cout << setw(12) << "render()" << setw(10) << sequential << " ms"
+         << setw(10) << megabytes/(sequential/1000) << " MB/s" << endl;
+
+    size_t cores=max(1u, thread::hardware_concurrency());
+    for(size_t threads=1; threads<=cores; threads*=2){
+        double ms=bestMillis(3, [&]{ sink=sink+doc.renderParallel(threads).size(); });
+        cout << setw(9) << threads << " th" << setw(10) << ms << " ms"
+             << setw(10) << megabytes/(ms/1000) << " MB/s"
+             << setw(8) << sequential/ms << "x" << endl;
+    }
+    return 0;
+}
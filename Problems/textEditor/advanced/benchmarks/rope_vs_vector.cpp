@@ -0,0 +1,74 @@
+// Compares the treap-backed Document against the flat vector layout from
+// basic/good.cpp on a document of 10^6 elements.
+//
+//   g++ -std=c++17 -O2 rope_vs_vector.cpp -o rope_vs_vector && ./rope_vs_vector
+
+#include<iostream>
+#include<vector>
+#include<string>
+#include<chrono>
+#include<random>
+#include "../models/Document.h"
+
+using namespace std;
+
+// The original layout: one vector, so a middle insert shifts the tail.
+class VectorDocument{
+private:
+    vector<DocumentElement*> documentElements;
+
+public:
+    void addElement(DocumentElement* element){
+        documentElements.push_back(element);
+    }
+    void insertElement(size_t pos, DocumentElement* element){
+        documentElements.insert(documentElements.begin()+pos, element);
+    }
+    DocumentElement* eraseElement(size_t pos){
+        DocumentElement* element=documentElements[pos];
+        documentElements.erase(documentElements.begin()+pos);
+        return element;
+    }
+    size_t size() const{
+        return documentElements.size();
+    }
+};
+
+template<typename F>
+double millis(F fn){
+    auto start=chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now()-start).count();
+}
+
+template<typename Doc>
+void run(const string& name, size_t elements, size_t edits, DocumentElement* element){
+    Doc doc;
+    double build=millis([&]{
+        for(size_t i=0;i<elements;i++) doc.addElement(element);
+    });
+
+    mt19937_64 rng(42);
+    double insert=millis([&]{
+        for(size_t i=0;i<edits;i++) doc.insertElement(rng()%(doc.size()+1), element);
+    });
+    double erase=millis([&]{
+        for(size_t i=0;i<edits;i++) doc.eraseElement(rng()%doc.size());
+    });
+
+    cout << name
+         << "  append: " << build << " ms"
+         << "  insert: " << insert*1000/edits << " us/op"
+         << "  erase: " << erase*1000/edits << " us/op" << endl;
+}
+
+int main(){
+    const size_t elements=1000000;
+    const size_t edits=20000;
+    TextElement element("lorem ipsum");
+
+    cout << elements << " elements, " << edits << " random-position edits" << endl;
+    run<VectorDocument>("vector", elements, edits, &element);
+    run<Document>("treap ", elements, edits, &element);
+    return 0;
+}
@@ -0,0 +1,329 @@
+#ifndef DOCUMENT_EDITOR_H
+#define DOCUMENT_EDITOR_H
+
+#include<string>
+#include<vector>
+#include<stdexcept>
+#include<deque>
+#include<memory>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include "../models/Document.h"
+#include "../storage/Persistence.h"
+#include "../search/DocumentIndex.h"
+#include "EditHistory.h"
+#include "RenderCache.h"
+
+using namespace std;
+
+class DocumentEditor {
+private:
+    Document* document;
+    Persistence* storage;
+    RenderCache renderCache;
+    bool rendered = false;
+    // Changes since the last save, kept only for storage that supports them.
+    vector<TextChange> unsavedChanges;
+    bool savedOnce = false;
+    EditHistory history;
+    // Built by the first search and kept up to date by apply().
+    DocumentIndex index;
+    bool indexed = false;
+
+    // One queued save: the document as of saveDocument(), plus the changes
+    // since the previous save when storage takes changes.
+    struct SaveJob {
+        shared_ptr<Document::Snapshot> snapshot;
+        vector<TextChange> changes;
+        bool incremental;
+    };
+
+    // Saves run in order on one background thread, started by the first save.
+    thread saver;
+    mutex saveLock;
+    condition_variable saveQueued;
+    condition_variable saveFinished;
+    deque<SaveJob> saveQueue;
+    bool saving = false;
+    bool stopSaver = false;
+
+    void saveLoop() {
+        unique_lock<mutex> lock(saveLock);
+        while(true) {
+            saveQueued.wait(lock, [&] { return stopSaver || !saveQueue.empty(); });
+            if(saveQueue.empty()) return;
+            SaveJob job = move(saveQueue.front());
+            saveQueue.pop_front();
+            saving = true;
+            lock.unlock();
+
+            if(!job.incremental || !storage->saveChanges(job.changes)) {
+                storage->saveDocument(*job.snapshot);
+            }
+            job.snapshot.reset();
+
+            lock.lock();
+            saving = false;
+            saveFinished.notify_all();
+        }
+    }
+
+    bool tracksChanges() const {
+        return savedOnce && storage->supportsChanges();
+    }
+
+    // `erased` bytes at offset were replaced by `inserted` ones; text() gives
+    // them and is only called when the render cache or the saved changes
+    // need the bytes.
+    template<typename Text>
+    void recordSplice(size_t offset, size_t erased, size_t inserted, Text text) {
+        if(indexed) index.splice(offset, erased, inserted);
+        if(!rendered && !tracksChanges()) return;
+        string bytes = text();
+        if(rendered) renderCache.splice(offset, erased, bytes);
+        if(tracksChanges()) {
+            unsavedChanges.push_back({offset, erased, move(bytes)});
+        }
+    }
+
+    // Every change to the document goes through apply(), so the render cache
+    // and the search index stay in sync for edits, undo and redo alike. An
+    // erase records the element it actually took out in op.
+    void apply(EditOp& op) {
+        if(op.kind == EditOp::INSERT) {
+            document->insertElement(op.pos, op.element);
+            if(rendered || tracksChanges() || indexed) {
+                DocumentElement* element = op.element;
+                recordSplice(document->offsetOf(op.pos), 0, element->length(), [&] { return element->render(); });
+            }
+        } else if(op.kind == EditOp::ERASE) {
+            size_t offset = document->offsetOf(op.pos);
+            op.element = document->eraseElement(op.pos);
+            recordSplice(offset, op.element->length(), 0, [] { return string(); });
+        } else {
+            applyText(op);
+        }
+    }
+
+    // Swaps the text element at op.pos for an owned copy with the delta
+    // applied. Only the delta reaches the render cache and the saved changes.
+    // The old element is freed: undo rebuilds it from the delta.
+    void applyText(const EditOp& op) {
+        TextElement* old = static_cast<TextElement*>(document->elementAt(op.pos));
+        string_view current = old->getText();
+        string_view erased = op.erasedText();
+        string_view inserted = op.insertedText();
+        string edited;
+        edited.reserve(current.size() - erased.size() + inserted.size());
+        edited.append(current.substr(0, op.offset));
+        edited.append(inserted);
+        edited.append(current.substr(op.offset + erased.size()));
+
+        TextElement* replacement = document->arena().makeText(edited);
+        document->replaceElement(op.pos, replacement);
+        recordSplice(document->offsetOf(op.pos) + op.offset, erased.size(), inserted.size(), [&] { return string(inserted); });
+        document->releaseElement(old);
+    }
+
+    void record(EditOp op) {
+        apply(op);
+        history.record(move(op));
+    }
+
+    void commit() {
+        history.commit([&](DocumentElement* element) {
+            document->releaseElement(element);
+        });
+    }
+
+    // Calls fn(offset) for each occurrence of pattern in the rendered document
+    // that starts at or after from, in order, until fn returns false.
+    template<typename F>
+    void forEachMatch(const string& pattern, size_t from, F fn) {
+        if(!indexed) {
+            index.reset(document->renderedLength());
+            indexed = true;
+        }
+        index.forEachMatch(*document, pattern, from, fn);
+    }
+
+    void insertElement(size_t pos, DocumentElement* element) {
+        if(pos > document->size()) {
+            throw out_of_range("DocumentEditor: position past end");
+        }
+        record(EditOp::insertion(element, pos));
+        commit();
+    }
+
+public:
+    DocumentEditor(Document* document, Persistence* storage) {
+        this->document = document;
+        this->storage = storage;
+    }
+
+    // Finishes the saves that are still queued.
+    ~DocumentEditor() {
+        {
+            lock_guard<mutex> lock(saveLock);
+            stopSaver = true;
+        }
+        saveQueued.notify_one();
+        if(saver.joinable()) saver.join();
+    }
+
+    void addText(string text) {
+        insertElement(document->size(), document->arena().makeText(text));
+    }
+
+    void addImage(string imagePath) {
+        insertElement(document->size(), document->arena().makeImage(imagePath));
+    }
+
+    // Adds a new line to the document.
+    void addNewLine() {
+        insertElement(document->size(), document->arena().makeNewLine());
+    }
+
+    void insertText(size_t pos, string text) {
+        insertElement(pos, document->arena().makeText(text));
+    }
+
+    void insertImage(size_t pos, string imagePath) {
+        insertElement(pos, document->arena().makeImage(imagePath));
+    }
+
+    void insertNewLine(size_t pos) {
+        insertElement(pos, document->arena().makeNewLine());
+    }
+
+    // Removes the element at pos.
+    void erase(size_t pos) {
+        record(EditOp::erasure(document->elementAt(pos), pos));
+        commit();
+    }
+
+    // Replaces count bytes at offset inside the text element at pos with text.
+    // The element is rebuilt as an owned copy, which is how text borrowed from
+    // a mapped file moves to the heap; the history keeps only the replaced and
+    // the new bytes.
+    void editText(size_t pos, size_t offset, size_t count, const string& text) {
+        TextElement* element = dynamic_cast<TextElement*>(document->elementAt(pos));
+        if(element == nullptr) {
+            throw invalid_argument("DocumentEditor::editText: not a text element");
+        }
+        string_view current = element->getText();
+        if(offset > current.size()) {
+            throw out_of_range("DocumentEditor::editText: offset past end of text");
+        }
+        count = min(count, current.size() - offset);
+        record(EditOp::textEdit(pos, offset, current.substr(offset, count), text));
+        commit();
+    }
+
+    // Undo and redo work on whole editor calls and cost O(size of that
+    // change), independent of document size. Return false when there is
+    // nothing to undo or redo.
+    bool undo() {
+        return history.undo([&](EditOp& op) { apply(op); });
+    }
+
+    bool redo() {
+        return history.redo([&](EditOp& op) { apply(op); });
+    }
+
+    // Caps the memory the undo log may hold, in bytes (default 64 MB).
+    void setHistoryLimit(size_t maxBytes) {
+        history.setLimit(maxBytes);
+    }
+
+    // Offsets in renderDocument() of every occurrence of pattern, overlapping
+    // ones included. The first search indexes the document; later ones only
+    // read the chunks of it that can contain pattern, and the chunks edited
+    // since the last search.
+    vector<size_t> findAll(const string& pattern) {
+        vector<size_t> offsets;
+        forEachMatch(pattern, 0, [&](size_t offset) {
+            offsets.push_back(offset);
+            return true;
+        });
+        return offsets;
+    }
+
+    // Offset of the first occurrence of pattern at or after from, or
+    // string::npos.
+    size_t find(const string& pattern, size_t from = 0) {
+        size_t found = string::npos;
+        forEachMatch(pattern, from, [&](size_t offset) {
+            found = offset;
+            return false;
+        });
+        return found;
+    }
+
+    size_t lineCount() {
+        return document->lineCount();
+    }
+
+    // Offset in renderDocument() where line starts (lines count from 0).
+    size_t gotoLine(size_t line) {
+        return document->lineOffset(line);
+    }
+
+    // Line that offset in renderDocument() falls on.
+    size_t lineAt(size_t offset) {
+        return document->lineAt(offset);
+    }
+
+    // Renders only lines [first, last), e.g. the visible part of a view,
+    // without rendering the rest of the document.
+    string renderLines(size_t first, size_t last) {
+        return document->renderLines(first, last);
+    }
+
+    size_t elementCount() const {
+        return document->size();
+    }
+
+    // The rendered document. The first call renders everything, in parallel
+    // for large documents. After that each edit is spliced into the chunk of
+    // the cache it lands in as it happens, at O(chunk + size of the change),
+    // and nothing is rendered again. Stream the result, or call str() on it
+    // when one string is really needed.
+    const RenderCache& renderDocument() {
+        if(!rendered) {
+            renderCache.assign(*document);
+            rendered = true;
+        }
+        return renderCache;
+    }
+
+    // A consistent, read-only view of the document for other threads, such
+    // as a preview renderer; editing carries on while they read it.
+    shared_ptr<Document::Snapshot> snapshot() {
+        return document->snapshot();
+    }
+
+    // Takes an O(1) snapshot and returns; a background thread streams it to
+    // storage, so a slow disk never holds up editing. Storage that supports
+    // it only receives the changes since the last save.
+    void saveDocument() {
+        SaveJob job = {document->snapshot(), move(unsavedChanges), tracksChanges()};
+        unsavedChanges.clear();
+        savedOnce = true;
+        {
+            lock_guard<mutex> lock(saveLock);
+            saveQueue.push_back(move(job));
+            if(!saver.joinable()) saver = thread(&DocumentEditor::saveLoop, this);
+        }
+        saveQueued.notify_one();
+    }
+
+    // Blocks until every save queued so far is written.
+    void waitForSaves() {
+        unique_lock<mutex> lock(saveLock);
+        saveFinished.wait(lock, [&] { return saveQueue.empty() && !saving; });
+    }
+};
+
+#endif
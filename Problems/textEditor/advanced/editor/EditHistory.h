@@ -0,0 +1,184 @@
+#ifndef EDIT_HISTORY_H
+#define EDIT_HISTORY_H
+
+#include<deque>
+#include<vector>
+#include<string>
+#include<string_view>
+#include<algorithm>
+#include "../models/DocumentElement.h"
+
+using namespace std;
+
+// One reversible step. INSERT and ERASE put element at, or take it from,
+// pos; elements are immutable and owned by the document's arena, so those
+// steps are a pointer and a position no matter how large the element is.
+// TEXT replaces erasedText() with insertedText() at byte offset of the text
+// element at pos, and keeps only those bytes, not the element.
+struct EditOp {
+    enum Kind { INSERT, ERASE, TEXT };
+
+    Kind kind;
+    DocumentElement* element;
+    size_t pos;
+    size_t offset;
+    // The erased bytes followed by the inserted ones.
+    string text;
+    size_t erasedLength;
+
+    static EditOp insertion(DocumentElement* element, size_t pos) {
+        return {INSERT, element, pos, 0, string(), 0};
+    }
+
+    static EditOp erasure(DocumentElement* element, size_t pos) {
+        return {ERASE, element, pos, 0, string(), 0};
+    }
+
+    static EditOp textEdit(size_t pos, size_t offset, string_view erased, string_view inserted) {
+        string text;
+        text.reserve(erased.size() + inserted.size());
+        text.append(erased);
+        text.append(inserted);
+        return {TEXT, nullptr, pos, offset, move(text), erased.size()};
+    }
+
+    string_view erasedText() const {
+        return string_view(text).substr(0, erasedLength);
+    }
+
+    string_view insertedText() const {
+        return string_view(text).substr(erasedLength);
+    }
+
+    EditOp inverse() const {
+        if(kind == TEXT) return textEdit(pos, offset, insertedText(), erasedText());
+        return {kind == INSERT ? ERASE : INSERT, element, pos, 0, string(), 0};
+    }
+};
+
+// Undo/redo log of EditOps, grouped so one editor call undoes as a unit.
+// Undo and redo cost O(ops in the group + bytes they change). The log is
+// kept under maxBytes: each step is charged its own size plus the text it
+// keeps alive (the delta of a TEXT step, the element held by an ERASE step),
+// and the oldest groups are dropped once the total passes the budget.
+// Elements that can no longer come back are handed to the release callback
+// so their memory is reused.
+//
+// Whoever applies a step may swap the element it erases for the one actually
+// at pos (a TEXT step replaces elements), so steps are stored as applied.
+class EditHistory {
+private:
+    deque<EditOp> undoOps;
+    deque<size_t> undoGroups;
+    vector<EditOp> redoOps;
+    vector<size_t> redoGroups;
+    size_t openOps = 0;
+    size_t undoBytes = 0;
+    size_t maxBytes;
+
+    static size_t footprint(const EditOp& op) {
+        size_t bytes = sizeof(EditOp) + op.text.size();
+        if(op.kind == EditOp::ERASE) {
+            TextElement* text = dynamic_cast<TextElement*>(op.element);
+            if(text != nullptr && !text->isBorrowed()) bytes += text->getText().size();
+        }
+        return bytes;
+    }
+
+public:
+    EditHistory(size_t maxBytes = 64 << 20) {
+        this->maxBytes = maxBytes;
+    }
+
+    void setLimit(size_t maxBytes) {
+        this->maxBytes = maxBytes;
+    }
+
+    void record(EditOp op) {
+        undoBytes += footprint(op);
+        undoOps.push_back(move(op));
+        openOps++;
+    }
+
+    // Closes the group of ops recorded since the last commit. A new edit
+    // discards the redo log; elements inserted by redo steps are gone for
+    // good, as are elements erased by steps that fall off the old end.
+    template<typename Release>
+    void commit(Release release) {
+        if(openOps == 0) return;
+        undoGroups.push_back(openOps);
+        openOps = 0;
+
+        for(const EditOp& op : redoOps) {
+            if(op.kind == EditOp::INSERT) release(op.element);
+        }
+        redoOps.clear();
+        redoGroups.clear();
+
+        while(undoBytes > maxBytes && undoGroups.size() > 1) {
+            for(size_t i = 0; i < undoGroups.front(); i++) {
+                const EditOp& op = undoOps.front();
+                undoBytes -= footprint(op);
+                if(op.kind == EditOp::ERASE) release(op.element);
+                undoOps.pop_front();
+            }
+            undoGroups.pop_front();
+        }
+    }
+
+    bool canUndo() const {
+        return !undoGroups.empty();
+    }
+
+    bool canRedo() const {
+        return !redoGroups.empty();
+    }
+
+    // Applies the inverse of the newest group, newest op first.
+    template<typename Apply>
+    bool undo(Apply apply) {
+        if(!canUndo()) return false;
+        size_t count = undoGroups.back();
+        undoGroups.pop_back();
+        size_t first = redoOps.size();
+        for(size_t i = 0; i < count; i++) {
+            EditOp inverse = undoOps.back().inverse();
+            undoBytes -= footprint(undoOps.back());
+            undoOps.pop_back();
+            apply(inverse);
+            redoOps.push_back(inverse.inverse());
+        }
+        // Keep each redo group in its original order.
+        reverse(redoOps.begin() + first, redoOps.end());
+        redoGroups.push_back(count);
+        return true;
+    }
+
+    // Re-applies the most recently undone group, oldest op first.
+    template<typename Apply>
+    bool redo(Apply apply) {
+        if(!canRedo()) return false;
+        size_t count = redoGroups.back();
+        redoGroups.pop_back();
+        size_t first = redoOps.size() - count;
+        for(size_t i = first; i < redoOps.size(); i++) {
+            apply(redoOps[i]);
+            undoBytes += footprint(redoOps[i]);
+            undoOps.push_back(move(redoOps[i]));
+        }
+        redoOps.resize(first);
+        undoGroups.push_back(count);
+        return true;
+    }
+
+    size_t size() const {
+        return undoOps.size() + redoOps.size();
+    }
+
+    // Bytes charged to the undo log.
+    size_t bytes() const {
+        return undoBytes;
+    }
+};
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+#include<thread>
+#include<ostream>
+#include<algorithm>
+#include "../models/Document.h"
+#include "../models/RenderSink.h"
+#include "../models/FenwickTree.h"
+
+using namespace std;
+
+// The editor's rendered copy of the document, kept as a list of chunks of
+// about chunkBytes instead of one string. A splice rewrites only the chunks
+// it lands in, so keeping the copy current costs O(log chunks + chunkBytes +
+// size of the change) per edit, however large the document is. A Fenwick tree
+// over the chunk sizes finds the chunk holding an offset.
+//
+// Chunks are re-cut only when one grows past maxChunk or shrinks below
+// minChunk; that touches the chunk list, which is amortized over the bytes
+// edited since the last re-cut.
+//
+// Readers stream the chunks (renderTo, operator<<). str() joins them into one
+// string on demand and keeps it until the next splice.
+class RenderCache {
+private:
+    static constexpr size_t chunkBytes = 64 * 1024;
+    static constexpr size_t maxChunk = 4 * chunkBytes;
+    static constexpr size_t minChunk = chunkBytes / 4;
+
+    vector<string> chunks;
+    FenwickTree offsets;
+    size_t total = 0;
+    mutable string flat;
+    mutable bool flatValid = false;
+
+    void rebuildTree() {
+        offsets.assign(chunks.size(), [&](size_t i) { return chunks[i].size(); });
+    }
+
+    // Chunk holding offset and the offset inside it. An offset on a boundary
+    // belongs to the chunk that starts there; total belongs to the last one.
+    pair<size_t, size_t> locate(size_t offset) const {
+        size_t chunk = offsets.find(offset);
+        if(chunk == chunks.size()) return {chunk - 1, chunks[chunk - 1].size()};
+        return {chunk, offset};
+    }
+
+    // Re-cuts chunks [first, last] and one neighbour on each side into
+    // pieces of chunkBytes to 2 * chunkBytes.
+    void recut(size_t first, size_t last) {
+        if(first > 0) first--;
+        if(last + 1 < chunks.size()) last++;
+        string joined;
+        for(size_t i = first; i <= last; i++) {
+            joined.append(chunks[i]);
+        }
+        size_t pieces = joined.empty() ? 0 : max<size_t>(1, joined.size() / chunkBytes);
+        vector<string> cut(pieces);
+        for(size_t i = 0, at = 0; i < pieces; i++) {
+            size_t end = (i + 1 == pieces) ? joined.size() : joined.size() / pieces * (i + 1);
+            cut[i].assign(joined, at, end - at);
+            at = end;
+        }
+        chunks.erase(chunks.begin() + first, chunks.begin() + last + 1);
+        chunks.insert(chunks.begin() + first, make_move_iterator(cut.begin()), make_move_iterator(cut.end()));
+        rebuildTree();
+    }
+
+public:
+    // Renders document from scratch on up to `threads` threads (0 = one per
+    // core); each chunk is rendered straight from the document with
+    // renderRangeTo, so workers need no coordination. Small documents render
+    // on the calling thread.
+    void assign(const Document& document, size_t threads = 0) {
+        static const size_t minBytesPerThread = 1 << 20;
+        total = document.renderedLength();
+        chunks.assign((total + chunkBytes - 1) / chunkBytes, string());
+        if(threads == 0) threads = max(1u, thread::hardware_concurrency());
+        threads = max<size_t>(1, min(threads, total / minBytesPerThread));
+
+        auto renderChunks = [&](size_t worker) {
+            size_t first = chunks.size() * worker / threads;
+            size_t last = chunks.size() * (worker + 1) / threads;
+            for(size_t i = first; i < last; i++) {
+                size_t begin = i * chunkBytes;
+                chunks[i].reserve(min(chunkBytes, total - begin));
+                StringSink sink(chunks[i]);
+                document.renderRangeTo(begin, begin + chunkBytes, sink);
+            }
+        };
+        vector<thread> workers;
+        for(size_t i = 1; i < threads; i++) {
+            workers.emplace_back(renderChunks, i);
+        }
+        renderChunks(0);
+        for(auto& worker : workers) {
+            worker.join();
+        }
+        rebuildTree();
+        flat = string();
+        flatValid = false;
+    }
+
+    // Replaces `erased` bytes at offset with text.
+    void splice(size_t offset, size_t erased, string_view text) {
+        if(erased == 0 && text.empty()) return;
+        flat = string();
+        flatValid = false;
+        if(chunks.empty()) {
+            chunks.emplace_back();
+            rebuildTree();
+        }
+        auto [first, at] = locate(min(offset, total));
+        size_t last = first;
+        erased = min(erased, total - min(offset, total));
+        total -= erased;
+        while(erased > 0) {
+            size_t take = min(erased, chunks[last].size() - at);
+            chunks[last].erase(at, take);
+            offsets.add(last, 0 - take);
+            erased -= take;
+            if(erased > 0) {
+                last++;
+                at = 0;
+            }
+        }
+        chunks[first].insert(at, text.data(), text.size());
+        offsets.add(first, text.size());
+        total += text.size();
+
+        for(size_t i = first; i <= last; i++) {
+            size_t size = chunks[i].size();
+            if(size > maxChunk || (size < minChunk && chunks.size() > 1)) {
+                recut(first, last);
+                return;
+            }
+        }
+    }
+
+    void clear() {
+        chunks.clear();
+        offsets.clear();
+        total = 0;
+        flat = string();
+        flatValid = false;
+    }
+
+    size_t size() const {
+        return total;
+    }
+
+    bool empty() const {
+        return total == 0;
+    }
+
+    size_t chunkCount() const {
+        return chunks.size();
+    }
+
+    // Calls fn(string_view) on each chunk in order.
+    template<typename F>
+    void forEachChunk(F fn) const {
+        for(const string& chunk : chunks) {
+            fn(string_view(chunk));
+        }
+    }
+
+    void renderTo(RenderSink& sink) const {
+        for(const string& chunk : chunks) {
+            sink.write(chunk.data(), chunk.size());
+        }
+    }
+
+    // The whole text as one string: O(size) the first time after a splice.
+    const string& str() const {
+        if(!flatValid) {
+            flat.reserve(total);
+            for(const string& chunk : chunks) {
+                flat.append(chunk);
+            }
+            flatValid = true;
+        }
+        return flat;
+    }
+
+    friend ostream& operator<<(ostream& out, const RenderCache& text) {
+        for(const string& chunk : text.chunks) {
+            out.write(chunk.data(), chunk.size());
+        }
+        return out;
+    }
+};
+
+#endif
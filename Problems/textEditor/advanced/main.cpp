@@ -0,0 +1,62 @@
+#include<iostream>
+#include "models/Document.h"
+#include "storage/FileStorage.h"
+#include "storage/DocumentLoader.h"
+#include "editor/DocumentEditor.h"
+
+using namespace std;
+
+int main() {
+    Document* document = new Document();
+    Persistence* persistence = new FileStorage();
+
+    DocumentEditor* editor = new DocumentEditor(document, persistence);
+
+    editor->addText("Hello, world!");
+    editor->addNewLine();
+    editor->addText("This is a real-world document editor example.");
+    editor->addNewLine();
+    editor->addText("Indented text after a tab space.");
+    editor->addNewLine();
+    editor->addImage("picture.jpg");
+
+    // Edits in the middle no longer shift everything after them.
+    editor->insertText(2, "Inserted before the second paragraph.");
+    editor->insertNewLine(3);
+
+    cout << editor->renderDocument() << endl;
+
+    // Take back both insertions, then redo them.
+    editor->undo();
+    editor->undo();
+    editor->redo();
+    editor->redo();
+    cout << editor->renderDocument() << endl;
+
+    cout << "\"world\" found at offsets:";
+    for (size_t offset : editor->findAll("world")) {
+        cout << " " << offset;
+    }
+    cout << endl;
+
+    // Only lines 1 and 2 are rendered.
+    cout << editor->renderLines(1, 3);
+
+    // Saving runs in the background; wait before reading the file back.
+    editor->saveDocument();
+    editor->waitForSaves();
+
+    // Reopen the saved file; its text stays in the mapping until edited.
+    Document* reopened = new Document();
+    if (DocumentLoader::load("document.txt", *reopened)) {
+        DocumentEditor reopenedEditor(reopened, persistence);
+        reopenedEditor.editText(0, 0, 5, "Goodbye");
+        cout << reopenedEditor.renderDocument() << endl;
+    }
+    delete reopened;
+
+    delete editor;
+    delete persistence;
+    delete document;
+    return 0;
+}
@@ -0,0 +1,627 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include<string>
+#include<cstdint>
+#include<stdexcept>
+#include<vector>
+#include<memory>
+#include<thread>
+#include<mutex>
+#include<atomic>
+#include<algorithm>
+#include "DocumentElement.h"
+#include "RenderSink.h"
+#include "ElementArena.h"
+#include "SlabPool.h"
+
+using namespace std;
+
+// Elements are kept in an implicit treap (a randomized balanced tree keyed by
+// position), so inserting or erasing anywhere is O(log n) instead of shifting
+// every element that comes after it. Each node also caches the rendered length
+// of its subtree, which maps an element position to its offset in render(),
+// and the number of line breaks in it, which maps a line to its offset.
+// Line breaks are counted the first time lines are asked for, and then only
+// in subtrees changed since, so building a document (e.g. from a mapped file)
+// never reads its elements.
+//
+// Elements made through arena() and the tree nodes are allocated from slabs
+// owned by the document and released together when it is destroyed. Elements
+// from anywhere else must outlive the document.
+//
+// snapshot() returns an immutable view of the current version in O(1). Nodes
+// are reference counted and shared between versions: an edit copies only the
+// shared nodes on its path (O(log n) of them) and leaves the snapshot's
+// nodes untouched, so other threads can read a snapshot without locks while
+// the document keeps changing. Only the thread that edits the document
+// touches reference counts and frees nodes; a snapshot dropped on another
+// thread is queued and reclaimed by the next edit.
+class Document{
+private:
+    // Line breaks of a node or subtree that have not been counted yet.
+    static constexpr size_t uncounted=SIZE_MAX;
+
+    struct Node{
+        DocumentElement* element;
+        Node* left;
+        Node* right;
+        uint32_t priority;
+        // Parents, versions and snapshots pointing at this node.
+        uint32_t refs;
+        size_t size;
+        size_t length;
+        size_t totalLength;
+        size_t newlines;
+        size_t totalNewlines;
+
+        Node(DocumentElement* element, uint32_t priority){
+            this->element=element;
+            this->left=nullptr;
+            this->right=nullptr;
+            this->priority=priority;
+            this->refs=1;
+            this->size=1;
+            this->length=element->length();
+            this->totalLength=length;
+            this->newlines=uncounted;
+            this->totalNewlines=uncounted;
+        }
+    };
+
+    // Backing storage that borrowed elements point into (e.g. a mapped file).
+    vector<shared_ptr<void>> retained;
+    ElementArena elements;
+    SlabPool<Node> nodes;
+    Node* root=nullptr;
+    uint32_t seed=2463534242u;
+
+    // Roots of dropped snapshots, waiting for the editing thread.
+    mutex retiredLock;
+    vector<Node*> retired;
+    atomic<bool> hasRetired{false};
+    size_t openSnapshots=0;
+    // Elements released while a snapshot may still render them.
+    vector<DocumentElement*> deferred;
+
+    uint32_t nextPriority(){
+        // xorshift32
+        seed^=seed<<13;
+        seed^=seed>>17;
+        seed^=seed<<5;
+        return seed;
+    }
+
+    static size_t sizeOf(Node* node){
+        return node ? node->size : 0;
+    }
+
+    static size_t lengthOf(Node* node){
+        return node ? node->totalLength : 0;
+    }
+
+    static size_t newlinesOf(Node* node){
+        return node ? node->totalNewlines : 0;
+    }
+
+    static void update(Node* node){
+        node->size=1+sizeOf(node->left)+sizeOf(node->right);
+        node->totalLength=node->length+lengthOf(node->left)+lengthOf(node->right);
+        node->totalNewlines=uncounted;
+        if(node->newlines!=uncounted && newlinesOf(node->left)!=uncounted && newlinesOf(node->right)!=uncounted){
+            node->totalNewlines=node->newlines+newlinesOf(node->left)+newlinesOf(node->right);
+        }
+    }
+
+    // Line breaks in node's subtree, counting what is uncounted without
+    // storing it; for snapshots, which must not change shared nodes.
+    static size_t newlinesIn(Node* node){
+        size_t total=0;
+        while(node!=nullptr){
+            if(node->totalNewlines!=uncounted) return total+node->totalNewlines;
+            total+=newlinesIn(node->left);
+            total+=node->newlines!=uncounted ? node->newlines : node->element->lineBreaks();
+            node=node->right;
+        }
+        return total;
+    }
+
+    // The rendered text of element; scratch holds it unless the element
+    // already has it in memory.
+    static string_view textOf(DocumentElement* element, string& scratch){
+        if(TextElement* text=dynamic_cast<TextElement*>(element)) return text->getText();
+        scratch=element->render();
+        return scratch;
+    }
+
+    // Returns node itself if nothing else points at it, otherwise a private
+    // copy that takes over the caller's reference.
+    Node* own(Node* node){
+        if(node->refs==1) return node;
+        Node* copy=nodes.create(*node);
+        copy->refs=1;
+        if(copy->left) copy->left->refs++;
+        if(copy->right) copy->right->refs++;
+        node->refs--;
+        return copy;
+    }
+
+    // Drops one reference to node, freeing whatever is no longer shared.
+    void unref(Node* node){
+        vector<Node*> stack;
+        if(node) stack.push_back(node);
+        while(!stack.empty()){
+            Node* top=stack.back();
+            stack.pop_back();
+            if(--top->refs>0) continue;
+            if(top->left) stack.push_back(top->left);
+            if(top->right) stack.push_back(top->right);
+            nodes.release(top);
+        }
+    }
+
+    // Counts the line breaks of every uncounted node below node, copying
+    // shared nodes on the way like an edit does.
+    Node* countLines(Node* node){
+        if(node==nullptr || node->totalNewlines!=uncounted) return node;
+        node=own(node);
+        node->left=countLines(node->left);
+        node->right=countLines(node->right);
+        if(node->newlines==uncounted) node->newlines=node->element->lineBreaks();
+        update(node);
+        return node;
+    }
+
+    void countLines(){
+        root=countLines(root);
+    }
+
+    void retire(Node* snapshotRoot){
+        lock_guard<mutex> lock(retiredLock);
+        retired.push_back(snapshotRoot);
+        hasRetired.store(true, memory_order_release);
+    }
+
+    // Reclaims dropped snapshots; called by the editing thread.
+    void reclaim(){
+        if(!hasRetired.load(memory_order_acquire)) return;
+        vector<Node*> roots;
+        {
+            lock_guard<mutex> lock(retiredLock);
+            roots.swap(retired);
+            hasRetired.store(false, memory_order_relaxed);
+        }
+        for(Node* node : roots){
+            unref(node);
+            openSnapshots--;
+        }
+        if(openSnapshots==0){
+            for(DocumentElement* element : deferred){
+                elements.release(element);
+            }
+            deferred.clear();
+        }
+    }
+
+    // Splits node into [0, pos) and [pos, size).
+    void split(Node* node, size_t pos, Node*& left, Node*& right){
+        if(node==nullptr){
+            left=right=nullptr;
+            return;
+        }
+        node=own(node);
+        if(sizeOf(node->left)<pos){
+            split(node->right, pos-sizeOf(node->left)-1, node->right, right);
+            left=node;
+        } else {
+            split(node->left, pos, left, node->left);
+            right=node;
+        }
+        update(node);
+    }
+
+    Node* merge(Node* left, Node* right){
+        if(left==nullptr) return right;
+        if(right==nullptr) return left;
+        if(left->priority>right->priority){
+            left=own(left);
+            left->right=merge(left->right, right);
+            update(left);
+            return left;
+        }
+        right=own(right);
+        right->left=merge(left, right->left);
+        update(right);
+        return right;
+    }
+
+    template<typename F>
+    static void walk(Node* node, F& fn){
+        while(node!=nullptr){
+            walk(node->left, fn);
+            fn(node->element);
+            node=node->right;
+        }
+    }
+
+    // Visits positions [lo, hi) of node's subtree, skipping subtrees that lie
+    // entirely outside the range.
+    template<typename F>
+    static void walkRange(Node* node, size_t lo, size_t hi, F& fn){
+        while(node!=nullptr && lo<hi){
+            size_t leftSize=sizeOf(node->left);
+            if(lo<leftSize) walkRange(node->left, lo, min(hi, leftSize), fn);
+            if(lo<=leftSize && leftSize<hi) fn(node->element);
+            if(hi<=leftSize+1) return;
+            lo=lo>leftSize ? lo-leftSize-1 : 0;
+            hi-=leftSize+1;
+            node=node->right;
+        }
+    }
+
+public:
+    // A version of the document frozen when snapshot() was called. Any
+    // thread may read it, and it may be dropped on any thread, but it must
+    // not outlive its document.
+    class Snapshot{
+    private:
+        friend class Document;
+        Document* document;
+        Node* root;
+
+        Snapshot(Document* document, Node* root){
+            this->document=document;
+            this->root=root;
+        }
+
+    public:
+        Snapshot(const Snapshot&)=delete;
+        Snapshot& operator=(const Snapshot&)=delete;
+
+        ~Snapshot(){
+            document->retire(root);
+        }
+
+        size_t size() const{
+            return sizeOf(root);
+        }
+
+        size_t renderedLength() const{
+            return lengthOf(root);
+        }
+
+        size_t lineCount() const{
+            return newlinesIn(root)+1;
+        }
+
+        template<typename F>
+        void forEach(F fn) const{
+            walk(root, fn);
+        }
+
+        void renderTo(RenderSink& sink) const{
+            forEach([&](DocumentElement* element){
+                element->renderTo(sink);
+            });
+        }
+
+        string render() const{
+            string result;
+            result.reserve(renderedLength());
+            StringSink sink(result);
+            renderTo(sink);
+            return result;
+        }
+    };
+
+    Document(){}
+    Document(const Document&)=delete;
+    Document& operator=(const Document&)=delete;
+
+    ElementArena& arena(){
+        return elements;
+    }
+
+    // Keeps resource alive for as long as the document.
+    void retain(shared_ptr<void> resource){
+        retained.push_back(move(resource));
+    }
+
+    // O(1). Must be called on the thread that edits the document.
+    shared_ptr<Snapshot> snapshot(){
+        reclaim();
+        if(root) root->refs++;
+        openSnapshots++;
+        return shared_ptr<Snapshot>(new Snapshot(this, root));
+    }
+
+    // Frees an element made by arena() once no snapshot can still reach it.
+    void releaseElement(DocumentElement* element){
+        reclaim();
+        if(openSnapshots>0){
+            deferred.push_back(element);
+        } else {
+            elements.release(element);
+        }
+    }
+
+    void addElement(DocumentElement* element){
+        reclaim();
+        root=merge(root, nodes.create(element, nextPriority()));
+    }
+
+    void insertElement(size_t pos, DocumentElement* element){
+        if(pos>size()){
+            throw out_of_range("Document::insertElement: position past end");
+        }
+        reclaim();
+        Node *left, *right;
+        split(root, pos, left, right);
+        root=merge(merge(left, nodes.create(element, nextPriority())), right);
+    }
+
+    // Unlinks the element at pos and returns it; it stays owned by whoever
+    // allocated it.
+    DocumentElement* eraseElement(size_t pos){
+        if(pos>=size()){
+            throw out_of_range("Document::eraseElement: position past end");
+        }
+        reclaim();
+        Node *left, *mid, *right;
+        split(root, pos, left, right);
+        split(right, 1, mid, right);
+        DocumentElement* element=mid->element;
+        unref(mid);
+        root=merge(left, right);
+        return element;
+    }
+
+    // Puts element at pos in place of the one there, and returns that one.
+    DocumentElement* replaceElement(size_t pos, DocumentElement* element){
+        if(pos>=size()){
+            throw out_of_range("Document::replaceElement: position past end");
+        }
+        reclaim();
+        Node *left, *mid, *right;
+        split(root, pos, left, right);
+        split(right, 1, mid, right);
+        DocumentElement* old=mid->element;
+        unref(mid);
+        root=merge(merge(left, nodes.create(element, nextPriority())), right);
+        return old;
+    }
+
+    DocumentElement* elementAt(size_t pos) const{
+        if(pos>=size()){
+            throw out_of_range("Document::elementAt: position past end");
+        }
+        Node* node=root;
+        while(true){
+            size_t leftSize=sizeOf(node->left);
+            if(pos<leftSize){
+                node=node->left;
+            } else if(pos==leftSize){
+                return node->element;
+            } else {
+                pos-=leftSize+1;
+                node=node->right;
+            }
+        }
+    }
+
+    size_t size() const{
+        return sizeOf(root);
+    }
+
+    // Length of render(), in O(1).
+    size_t renderedLength() const{
+        return lengthOf(root);
+    }
+
+    // Offset in render() where the element at pos starts; pos == size() gives
+    // renderedLength().
+    size_t offsetOf(size_t pos) const{
+        if(pos>size()){
+            throw out_of_range("Document::offsetOf: position past end");
+        }
+        size_t offset=0;
+        Node* node=root;
+        while(node!=nullptr){
+            size_t leftSize=sizeOf(node->left);
+            if(pos<=leftSize){
+                node=node->left;
+            } else {
+                offset+=lengthOf(node->left)+node->length;
+                pos-=leftSize+1;
+                node=node->right;
+            }
+        }
+        return offset;
+    }
+
+    // Position of the element whose rendered output covers offset;
+    // offset >= renderedLength() gives size().
+    size_t positionAt(size_t offset) const{
+        if(offset>=renderedLength()) return size();
+        size_t pos=0;
+        Node* node=root;
+        while(true){
+            size_t leftLength=lengthOf(node->left);
+            if(offset<leftLength){
+                node=node->left;
+            } else if(offset<leftLength+node->length){
+                return pos+sizeOf(node->left);
+            } else {
+                offset-=leftLength+node->length;
+                pos+=sizeOf(node->left)+1;
+                node=node->right;
+            }
+        }
+    }
+
+    // Number of lines; a document with no line breaks has one. Line queries
+    // count the line breaks of elements added since the last one, so they
+    // are not const.
+    size_t lineCount(){
+        countLines();
+        return newlinesOf(root)+1;
+    }
+
+    // Offset in render() where line starts (lines count from 0). Finding the
+    // element is O(log n); the break is then located inside that element.
+    size_t lineOffset(size_t line){
+        if(line>=lineCount()){
+            throw out_of_range("Document::lineOffset: line past end");
+        }
+        if(line==0) return 0;
+        size_t offset=0;
+        Node* node=root;
+        while(true){
+            size_t leftNewlines=newlinesOf(node->left);
+            if(line<=leftNewlines){
+                node=node->left;
+            } else if(line<=leftNewlines+node->newlines){
+                offset+=lengthOf(node->left);
+                line-=leftNewlines;
+                string scratch;
+                string_view text=textOf(node->element, scratch);
+                size_t at=0;
+                while(true){
+                    at=text.find('\n', at)+1;
+                    if(--line==0) return offset+at;
+                }
+            } else {
+                line-=leftNewlines+node->newlines;
+                offset+=lengthOf(node->left)+node->length;
+                node=node->right;
+            }
+        }
+    }
+
+    // Line that offset falls on; offset >= renderedLength() gives the last.
+    size_t lineAt(size_t offset){
+        countLines();
+        size_t line=0;
+        Node* node=root;
+        while(node!=nullptr){
+            size_t leftLength=lengthOf(node->left);
+            if(offset<leftLength){
+                node=node->left;
+            } else if(offset<leftLength+node->length){
+                string scratch;
+                string_view text=textOf(node->element, scratch);
+                return line+newlinesOf(node->left)+count(text.begin(), text.begin()+(offset-leftLength), '\n');
+            } else {
+                line+=newlinesOf(node->left)+node->newlines;
+                offset-=leftLength+node->length;
+                node=node->right;
+            }
+        }
+        return line;
+    }
+
+    // Streams bytes [begin, end) of render() into sink, visiting only the
+    // elements that overlap the range.
+    void renderRangeTo(size_t begin, size_t end, RenderSink& sink) const{
+        end=min(end, renderedLength());
+        if(begin>=end) return;
+        size_t pos=positionAt(begin);
+        size_t offset=offsetOf(pos);
+        forEachInRange(pos, positionAt(end-1)+1, [&](DocumentElement* element){
+            size_t length=element->length();
+            size_t lo=max(begin, offset)-offset;
+            size_t hi=min(end, offset+length)-offset;
+            if(lo==0 && hi==length){
+                element->renderTo(sink);
+            } else {
+                string scratch;
+                string_view text=textOf(element, scratch);
+                if(scratch.empty()){
+                    sink.writeStable(text.data()+lo, hi-lo);
+                } else {
+                    sink.write(text.data()+lo, hi-lo);
+                }
+            }
+            offset+=length;
+        });
+    }
+
+    // Renders lines [first, last), each with its line break, in
+    // O(log n + size of the output).
+    string renderLines(size_t first, size_t last){
+        string result;
+        if(first>=min(last, lineCount())) return result;
+        size_t begin=lineOffset(first);
+        size_t end=last<lineCount() ? lineOffset(last) : renderedLength();
+        result.reserve(end-begin);
+        StringSink sink(result);
+        renderRangeTo(begin, end, sink);
+        return result;
+    }
+
+    // Visits every element in document order.
+    template<typename F>
+    void forEach(F fn) const{
+        walk(root, fn);
+    }
+
+    // Visits the elements at positions [lo, hi) in document order.
+    template<typename F>
+    void forEachInRange(size_t lo, size_t hi, F fn) const{
+        walkRange(root, lo, min(hi, size()), fn);
+    }
+
+    // Streams every element into sink without building the whole document.
+    void renderTo(RenderSink& sink) const{
+        forEach([&](DocumentElement* element){
+            element->renderTo(sink);
+        });
+    }
+
+    string render() {
+        string result;
+        result.reserve(renderedLength());
+        StringSink sink(result);
+        renderTo(sink);
+        return result;
+    }
+
+    // Renders on up to `threads` threads (0 = one per core). The output is
+    // sized once from renderedLength(); the document is cut into chunks of
+    // roughly equal output size, and each worker renders its chunk straight
+    // into its slice of the buffer. The subtree lengths give every chunk's
+    // offset without a separate counting pass. Small documents render on the
+    // calling thread.
+    string renderParallel(size_t threads=0) const{
+        static const size_t minBytesPerThread=1<<20;
+        size_t total=renderedLength();
+        if(threads==0) threads=max(1u, thread::hardware_concurrency());
+        threads=max<size_t>(1, min(threads, total/minBytesPerThread));
+
+        string result(total, '\0');
+        vector<size_t> bounds;
+        bounds.push_back(0);
+        for(size_t i=1;i<threads;i++){
+            bounds.push_back(max(bounds.back(), positionAt(total/threads*i)));
+        }
+        bounds.push_back(size());
+
+        auto renderChunk=[&](size_t chunk){
+            BufferSink sink(&result[0]+offsetOf(bounds[chunk]));
+            forEachInRange(bounds[chunk], bounds[chunk+1], [&](DocumentElement* element){
+                element->renderTo(sink);
+            });
+        };
+        vector<thread> workers;
+        for(size_t i=1;i<threads;i++){
+            workers.emplace_back(renderChunk, i);
+        }
+        renderChunk(0);
+        for(auto& worker : workers){
+            worker.join();
+        }
+        return result;
+    }
+};
+
+#endif
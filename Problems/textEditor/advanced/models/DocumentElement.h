@@ -0,0 +1,140 @@
+#ifndef DOCUMENT_ELEMENT_H
+#define DOCUMENT_ELEMENT_H
+
+#include<string>
+#include<string_view>
+#include<algorithm>
+#include "RenderSink.h"
+
+using namespace std;
+
+class DocumentElement{
+public:
+    virtual string render()=0;
+
+    // Length of render() without building the string.
+    virtual size_t length(){
+        return render().size();
+    }
+
+    virtual void renderTo(RenderSink& sink){
+        string out=render();
+        sink.write(out.data(), out.size());
+    }
+
+    // Number of '\n' in render().
+    virtual size_t lineBreaks(){
+        string out=render();
+        return count(out.begin(), out.end(), '\n');
+    }
+
+    virtual ~DocumentElement(){}
+};
+
+// Wraps text the element should point at rather than copy, such as a region
+// of a memory-mapped file. The owner must keep it alive as long as the element.
+struct BorrowedText{
+    string_view text;
+};
+
+class TextElement: public DocumentElement{
+private:
+    string owned;
+    string_view text;
+    bool borrowed;
+
+public:
+    TextElement(const string &txt){
+        this->owned=txt;
+        this->text=owned;
+        this->borrowed=false;
+    }
+
+    TextElement(BorrowedText borrowed){
+        this->text=borrowed.text;
+        this->borrowed=true;
+    }
+
+    TextElement(const TextElement&)=delete;
+    TextElement& operator=(const TextElement&)=delete;
+
+    string_view getText() const{
+        return text;
+    }
+
+    bool isBorrowed() const{
+        return borrowed;
+    }
+
+    string render() override{
+        return string(text);
+    }
+
+    size_t length() override{
+        return text.size();
+    }
+
+    void renderTo(RenderSink& sink) override{
+        sink.writeStable(text.data(), text.size());
+    }
+
+    size_t lineBreaks() override{
+        return count(text.begin(), text.end(), '\n');
+    }
+};
+
+// The rendered placeholder is built once and doubles as storage for the
+// path, so rendering is a single write with no allocation.
+class ImageElement: public DocumentElement{
+private:
+    string placeholder;
+
+public:
+    ImageElement(const string &img){
+        this->placeholder="[Image:"+img+"]";
+    }
+
+    ImageElement(const ImageElement&)=delete;
+    ImageElement& operator=(const ImageElement&)=delete;
+
+    string_view getPath() const{
+        return string_view(placeholder).substr(7, placeholder.size()-8);
+    }
+
+    string render() override{
+        return placeholder;
+    }
+
+    size_t length() override{
+        return placeholder.size();
+    }
+
+    void renderTo(RenderSink& sink) override{
+        sink.writeStable(placeholder.data(), placeholder.size());
+    }
+
+    size_t lineBreaks() override{
+        return count(placeholder.begin(), placeholder.end(), '\n');
+    }
+};
+
+class NewLineElement : public DocumentElement {
+public:
+    string render() override {
+        return "\n";
+    }
+
+    size_t length() override {
+        return 1;
+    }
+
+    void renderTo(RenderSink& sink) override {
+        sink.writeStable("\n", 1);
+    }
+
+    size_t lineBreaks() override {
+        return 1;
+    }
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef ELEMENT_ARENA_H
+#define ELEMENT_ARENA_H
+
+#include<string>
+#include "DocumentElement.h"
+#include "SlabPool.h"
+#include "ImageRegistry.h"
+
+using namespace std;
+
+// Owns every element of a document. Erasing an element from the document
+// does not free it (undo may bring it back); text elements are freed by
+// release() once nothing can reach them, or all at once with the arena.
+// NewLineElement has no state, so all new lines share one instance, and
+// images are interned by path so each picture has one element however often
+// it appears.
+class ElementArena{
+private:
+    SlabPool<TextElement> texts;
+    ImageRegistry imageRegistry;
+    NewLineElement newLine;
+
+public:
+    TextElement* makeText(const string& text){
+        return texts.create(text);
+    }
+
+    TextElement* makeText(BorrowedText text){
+        return texts.create(text);
+    }
+
+    ImageElement* makeImage(const string& imagePath){
+        return imageRegistry.intern(imagePath);
+    }
+
+    NewLineElement* makeNewLine(){
+        return &newLine;
+    }
+
+    ImageRegistry& images(){
+        return imageRegistry;
+    }
+
+    // Frees a text element made by this arena; shared elements and anything
+    // else are ignored.
+    void release(DocumentElement* element){
+        if(TextElement* text=dynamic_cast<TextElement*>(element)){
+            if(texts.owns(text)) texts.release(text);
+        }
+    }
+};
+
+#endif
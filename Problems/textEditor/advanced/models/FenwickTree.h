@@ -0,0 +1,72 @@
+#ifndef FENWICK_TREE_H
+#define FENWICK_TREE_H
+
+#include<vector>
+#include<cstddef>
+
+using namespace std;
+
+// Prefix sums over a list of sizes (a Fenwick, or binary indexed, tree).
+// Changing one size, summing the first k and finding the entry that holds an
+// offset are all O(log n); used to place offsets of a document cut into
+// chunks.
+class FenwickTree{
+private:
+    // 1-based.
+    vector<size_t> tree;
+
+public:
+    // Rebuilds from count sizes, sizeOf(i) giving the i-th, in O(count).
+    template<typename SizeOf>
+    void assign(size_t count, SizeOf sizeOf){
+        tree.assign(count+1, 0);
+        for(size_t i=1;i<=count;i++){
+            tree[i]+=sizeOf(i-1);
+            size_t parent=i+(i&(0-i));
+            if(parent<=count) tree[parent]+=tree[i];
+        }
+    }
+
+    // Sizes are unsigned, so a shrink is added as its two's complement.
+    void add(size_t index, size_t delta){
+        for(size_t i=index+1;i<tree.size();i+=i&(0-i)){
+            tree[i]+=delta;
+        }
+    }
+
+    // Sum of the first count sizes.
+    size_t prefix(size_t count) const{
+        size_t sum=0;
+        for(size_t i=count;i>0;i-=i&(0-i)){
+            sum+=tree[i];
+        }
+        return sum;
+    }
+
+    // Index of the entry holding offset; offset becomes the offset inside
+    // it. An offset on a boundary belongs to the entry that starts there, and
+    // one past the end gives size().
+    size_t find(size_t& offset) const{
+        size_t count=size();
+        size_t index=0;
+        size_t step=1;
+        while(step*2<=count) step*=2;
+        for(; count>0 && step>0; step/=2){
+            if(index+step<=count && tree[index+step]<=offset){
+                index+=step;
+                offset-=tree[index];
+            }
+        }
+        return index;
+    }
+
+    void clear(){
+        tree.clear();
+    }
+
+    size_t size() const{
+        return tree.empty() ? 0 : tree.size()-1;
+    }
+};
+
+#endif
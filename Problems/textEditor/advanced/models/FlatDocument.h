@@ -0,0 +1,130 @@
+#ifndef FLAT_DOCUMENT_H
+#define FLAT_DOCUMENT_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+#include<cstdint>
+#include<cstring>
+#include<stdexcept>
+#include "RenderSink.h"
+
+using namespace std;
+
+// Append-only, data-oriented alternative to Document for render-heavy use.
+// Instead of one heap object per element it keeps parallel arrays: a tag per
+// element, and for text an (offset, length) into a single text arena, for
+// images an index into imagePaths. Rendering is a switch over the tags that
+// copies straight into one preallocated string: no virtual calls and no
+// per-element allocation.
+class FlatDocument{
+private:
+    enum Tag: uint8_t { Text, Image, NewLine };
+
+    static constexpr string_view imagePrefix="[Image:";
+    static constexpr string_view imageSuffix="]";
+
+    vector<uint8_t> tags;
+    // Text: offset into textArena. Image: index into imagePaths.
+    vector<uint64_t> refs;
+    // Text: byte length. Unused for the other tags.
+    vector<uint32_t> lengths;
+    string textArena;
+    vector<string> imagePaths;
+    size_t totalLength=0;
+
+    void push(Tag tag, uint64_t ref, uint32_t length){
+        tags.push_back(tag);
+        refs.push_back(ref);
+        lengths.push_back(length);
+    }
+
+public:
+    void addText(string_view text){
+        if(text.size()>UINT32_MAX){
+            throw length_error("FlatDocument::addText: text element over 4 GB");
+        }
+        push(Text, textArena.size(), (uint32_t)text.size());
+        textArena.append(text);
+        totalLength+=text.size();
+    }
+
+    void addImage(const string& imagePath){
+        push(Image, imagePaths.size(), 0);
+        imagePaths.push_back(imagePath);
+        totalLength+=imagePrefix.size()+imagePath.size()+imageSuffix.size();
+    }
+
+    void addNewLine(){
+        push(NewLine, 0, 0);
+        totalLength+=1;
+    }
+
+    void reserve(size_t elements, size_t textBytes){
+        tags.reserve(elements);
+        refs.reserve(elements);
+        lengths.reserve(elements);
+        textArena.reserve(textBytes);
+    }
+
+    size_t size() const{
+        return tags.size();
+    }
+
+    size_t renderedLength() const{
+        return totalLength;
+    }
+
+    // Writes exactly renderedLength() bytes to out.
+    void renderInto(char* out) const{
+        const char* arena=textArena.data();
+        for(size_t i=0;i<tags.size();i++){
+            switch(tags[i]){
+            case Text:
+                memcpy(out, arena+refs[i], lengths[i]);
+                out+=lengths[i];
+                break;
+            case Image: {
+                const string& path=imagePaths[refs[i]];
+                memcpy(out, imagePrefix.data(), imagePrefix.size());
+                out+=imagePrefix.size();
+                memcpy(out, path.data(), path.size());
+                out+=path.size();
+                *out++=']';
+                break;
+            }
+            case NewLine:
+                *out++='\n';
+                break;
+            }
+        }
+    }
+
+    void renderTo(RenderSink& sink) const{
+        for(size_t i=0;i<tags.size();i++){
+            switch(tags[i]){
+            case Text:
+                sink.writeStable(textArena.data()+refs[i], lengths[i]);
+                break;
+            case Image: {
+                const string& path=imagePaths[refs[i]];
+                sink.writeStable(imagePrefix.data(), imagePrefix.size());
+                sink.writeStable(path.data(), path.size());
+                sink.writeStable(imageSuffix.data(), imageSuffix.size());
+                break;
+            }
+            case NewLine:
+                sink.writeStable("\n", 1);
+                break;
+            }
+        }
+    }
+
+    string render() const{
+        string result(totalLength, '\0');
+        renderInto(result.data());
+        return result;
+    }
+};
+
+#endif
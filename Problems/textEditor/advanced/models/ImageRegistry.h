@@ -0,0 +1,37 @@
+#ifndef IMAGE_REGISTRY_H
+#define IMAGE_REGISTRY_H
+
+#include<string>
+#include<string_view>
+#include<unordered_map>
+#include "DocumentElement.h"
+#include "SlabPool.h"
+
+using namespace std;
+
+// Interns images so a document that shows the same picture many times holds
+// one element for it: every use of a path shares that element, the way all
+// new lines share one. Elements are immutable, so sharing is safe, and they
+// live as long as the registry.
+class ImageRegistry{
+private:
+    SlabPool<ImageElement> images;
+    // Keys view the path inside each element.
+    unordered_map<string_view, ImageElement*> byPath;
+
+public:
+    ImageElement* intern(const string& path){
+        auto it=byPath.find(path);
+        if(it!=byPath.end()) return it->second;
+        ImageElement* image=images.create(path);
+        byPath.emplace(image->getPath(), image);
+        return image;
+    }
+
+    // Distinct paths interned so far.
+    size_t size() const{
+        return byPath.size();
+    }
+};
+
+#endif
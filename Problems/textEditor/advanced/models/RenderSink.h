@@ -0,0 +1,52 @@
+#ifndef RENDER_SINK_H
+#define RENDER_SINK_H
+
+#include<string>
+#include<cstring>
+
+using namespace std;
+
+// Destination for rendered output, so a document can be rendered piece by
+// piece instead of into one big string.
+class RenderSink{
+public:
+    // data is only valid for the duration of the call.
+    virtual void write(const char* data, size_t size)=0;
+
+    // data stays valid until the sink is flushed or destroyed, so sinks may
+    // keep a pointer to it instead of copying.
+    virtual void writeStable(const char* data, size_t size){
+        write(data, size);
+    }
+
+    virtual ~RenderSink(){}
+};
+
+class StringSink: public RenderSink{
+private:
+    string& out;
+
+public:
+    StringSink(string& out): out(out){}
+
+    void write(const char* data, size_t size) override{
+        out.append(data, size);
+    }
+};
+
+// Writes into caller-provided memory that is known to be large enough, e.g.
+// one chunk of a buffer sized from Document::renderedLength().
+class BufferSink: public RenderSink{
+private:
+    char* out;
+
+public:
+    BufferSink(char* out): out(out){}
+
+    void write(const char* data, size_t size) override{
+        memcpy(out, data, size);
+        out+=size;
+    }
+};
+
+#endif
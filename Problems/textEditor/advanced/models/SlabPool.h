@@ -0,0 +1,83 @@
+#ifndef SLAB_POOL_H
+#define SLAB_POOL_H
+
+#include<vector>
+#include<new>
+#include<utility>
+#include<algorithm>
+#include<functional>
+#include<type_traits>
+
+using namespace std;
+
+// Hands out objects of one type from contiguous slabs of slabObjects each,
+// so n objects cost n/slabObjects calls to the allocator. Objects can be
+// released early and their slots are reused; whatever is still alive is
+// destroyed, and every slab freed, when the pool goes away.
+template<typename T>
+class SlabPool{
+private:
+    static const size_t slabObjects=1024;
+
+    vector<T*> slabs;
+    // The same slabs ordered by address, for owns().
+    vector<T*> sortedSlabs;
+    size_t usedInLast=slabObjects;
+    vector<T*> freeList;
+
+public:
+    SlabPool(){}
+    SlabPool(const SlabPool&)=delete;
+    SlabPool& operator=(const SlabPool&)=delete;
+
+    ~SlabPool(){
+        if constexpr(!is_trivially_destructible<T>::value){
+            sort(freeList.begin(), freeList.end(), less<T*>());
+            for(size_t i=0;i<slabs.size();i++){
+                size_t count=(i+1==slabs.size()) ? usedInLast : slabObjects;
+                for(size_t j=0;j<count;j++){
+                    T* object=slabs[i]+j;
+                    if(!binary_search(freeList.begin(), freeList.end(), object, less<T*>())){
+                        object->~T();
+                    }
+                }
+            }
+        }
+        for(T* slab : slabs){
+            ::operator delete(slab);
+        }
+    }
+
+    template<typename... Args>
+    T* create(Args&&... args){
+        if(!freeList.empty()){
+            T* object=new(freeList.back()) T(forward<Args>(args)...);
+            freeList.pop_back();
+            return object;
+        }
+        if(usedInLast==slabObjects){
+            T* slab=static_cast<T*>(::operator new(sizeof(T)*slabObjects));
+            slabs.push_back(slab);
+            sortedSlabs.insert(upper_bound(sortedSlabs.begin(), sortedSlabs.end(), slab, less<T*>()), slab);
+            usedInLast=0;
+        }
+        T* object=new(slabs.back()+usedInLast) T(forward<Args>(args)...);
+        usedInLast++;
+        return object;
+    }
+
+    void release(T* object){
+        object->~T();
+        freeList.push_back(object);
+    }
+
+    // Whether object lives in one of this pool's slabs.
+    bool owns(const T* object) const{
+        auto it=upper_bound(sortedSlabs.begin(), sortedSlabs.end(), object, less<const T*>());
+        if(it==sortedSlabs.begin()) return false;
+        --it;
+        return less<const T*>()(object, *it+slabObjects);
+    }
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef DOCUMENT_INDEX_H
+#define DOCUMENT_INDEX_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+#include<algorithm>
+#include<cstdint>
+#include "../models/Document.h"
+#include "../models/RenderSink.h"
+#include "../models/FenwickTree.h"
+#include "TextIndex.h"
+#include "SubstringScan.h"
+
+using namespace std;
+
+// Substring search over a document's rendered text. The text is cut into
+// chunks of about chunkBytes and each chunk's trigrams go into a TextIndex,
+// so a search reads only the chunks that contain every trigram of the
+// pattern. Chunks are byte ranges, not runs of elements: how many there are
+// depends on the size of the document, not on how many elements it has.
+//
+// An occurrence that runs from one chunk into the next contains one of the
+// two trigrams that straddle the boundary, so a boundary is read only when
+// one of those is a trigram of the pattern. A search therefore costs one
+// comparison per chunk plus reading the candidate chunks and boundaries.
+//
+// splice() follows an edit by adjusting chunk sizes through a Fenwick tree
+// and marking the chunks it touches dirty; the next search reads and
+// re-indexes only those. Chunks are re-cut, like the render cache's, when one
+// grows past maxChunk or shrinks below minChunk.
+class DocumentIndex{
+private:
+    static constexpr size_t chunkBytes=64*1024;
+    static constexpr size_t maxChunk=4*chunkBytes;
+    static constexpr size_t minChunk=chunkBytes/4;
+
+    struct Chunk{
+        size_t size;
+        uint64_t key;
+        bool dirty;
+        // First and last two bytes, once indexed and if size >= 2.
+        char head[2];
+        char tail[2];
+    };
+
+    vector<Chunk> chunks;
+    FenwickTree offsets;
+    TextIndex trigrams;
+    size_t total=0;
+    size_t dirtyChunks=0;
+    uint64_t nextKey=0;
+    // Reused by every read so searching does not allocate per chunk.
+    string scratch;
+
+    Chunk makeChunk(size_t size){
+        dirtyChunks++;
+        return {size, nextKey++, true, {0, 0}, {0, 0}};
+    }
+
+    void markDirty(Chunk& chunk){
+        if(chunk.dirty) return;
+        chunk.dirty=true;
+        dirtyChunks++;
+    }
+
+    void rebuildOffsets(){
+        offsets.assign(chunks.size(), [&](size_t i){ return chunks[i].size; });
+    }
+
+    // Chunk holding offset and the offset inside it. An offset on a boundary
+    // belongs to the chunk that starts there; total belongs to the last one.
+    pair<size_t,size_t> locate(size_t offset) const{
+        size_t chunk=offsets.find(offset);
+        if(chunk==chunks.size()) return {chunk-1, chunks[chunk-1].size};
+        return {chunk, offset};
+    }
+
+    // Re-cuts chunks [first, last] and one neighbour on each side into
+    // pieces of chunkBytes to 2 * chunkBytes; the pieces are indexed by the
+    // next search.
+    void recut(size_t first, size_t last){
+        if(first>0) first--;
+        if(last+1<chunks.size()) last++;
+        size_t joined=0;
+        for(size_t i=first;i<=last;i++){
+            joined+=chunks[i].size;
+            trigrams.remove(chunks[i].key);
+            if(chunks[i].dirty) dirtyChunks--;
+        }
+        size_t pieces=joined==0 ? 0 : max<size_t>(1, joined/chunkBytes);
+        vector<Chunk> cut;
+        for(size_t i=0, at=0;i<pieces;i++){
+            size_t end=(i+1==pieces) ? joined : joined/pieces*(i+1);
+            cut.push_back(makeChunk(end-at));
+            at=end;
+        }
+        chunks.erase(chunks.begin()+first, chunks.begin()+last+1);
+        chunks.insert(chunks.begin()+first, cut.begin(), cut.end());
+        rebuildOffsets();
+    }
+
+    void read(const Document& document, size_t begin, size_t end){
+        scratch.clear();
+        StringSink sink(scratch);
+        document.renderRangeTo(begin, end, sink);
+    }
+
+    void refresh(const Document& document){
+        if(dirtyChunks==0) return;
+        size_t start=0;
+        for(Chunk& chunk : chunks){
+            if(chunk.dirty){
+                read(document, start, start+chunk.size);
+                trigrams.remove(chunk.key);
+                trigrams.add(chunk.key, scratch);
+                if(chunk.size>=2){
+                    copy_n(scratch.data(), 2, chunk.head);
+                    copy_n(scratch.data()+chunk.size-2, 2, chunk.tail);
+                }
+                chunk.dirty=false;
+            }
+            start+=chunk.size;
+        }
+        dirtyChunks=0;
+    }
+
+    // Whether an occurrence of a pattern with these (sorted) trigrams can
+    // cross the boundary after chunk i.
+    bool mayCross(size_t i, const vector<uint32_t>& patternTrigrams) const{
+        const Chunk& before=chunks[i];
+        const Chunk& after=chunks[i+1];
+        if(before.size<2 || after.size<2) return true;
+        char straddle[4]={before.tail[0], before.tail[1], after.head[0], after.head[1]};
+        return binary_search(patternTrigrams.begin(), patternTrigrams.end(), TextIndex::trigramAt(straddle))
+            || binary_search(patternTrigrams.begin(), patternTrigrams.end(), TextIndex::trigramAt(straddle+1));
+    }
+
+public:
+    // Starts over for a document of `total` rendered bytes. Nothing is read
+    // until the first search.
+    void reset(size_t total){
+        chunks.clear();
+        trigrams.clear();
+        dirtyChunks=0;
+        this->total=total;
+        for(size_t at=0;at<total;at+=chunkBytes){
+            chunks.push_back(makeChunk(min(chunkBytes, total-at)));
+        }
+        rebuildOffsets();
+    }
+
+    // Records that `erased` bytes at offset were replaced by `inserted` new
+    // ones; O(log chunks) unless a chunk has to be re-cut.
+    void splice(size_t offset, size_t erased, size_t inserted){
+        if(erased==0 && inserted==0) return;
+        if(chunks.empty()){
+            chunks.push_back(makeChunk(0));
+            rebuildOffsets();
+        }
+        offset=min(offset, total);
+        erased=min(erased, total-offset);
+        auto [first, at]=locate(offset);
+        size_t last=first;
+        total-=erased;
+        markDirty(chunks[first]);
+        while(erased>0){
+            size_t take=min(erased, chunks[last].size-at);
+            chunks[last].size-=take;
+            offsets.add(last, 0-take);
+            markDirty(chunks[last]);
+            erased-=take;
+            if(erased>0){
+                last++;
+                at=0;
+            }
+        }
+        chunks[first].size+=inserted;
+        offsets.add(first, inserted);
+        total+=inserted;
+
+        for(size_t i=first;i<=last;i++){
+            size_t size=chunks[i].size;
+            if(size>maxChunk || (size<minChunk && chunks.size()>1)){
+                recut(first, last);
+                return;
+            }
+        }
+    }
+
+    // Calls fn(offset) for each occurrence of pattern in document, which must
+    // be the text this index follows, that starts at or after from, in
+    // order, until fn returns false. Each occurrence is reported by the
+    // chunk it starts in.
+    template<typename F>
+    void forEachMatch(const Document& document, string_view pattern, size_t from, F fn){
+        if(pattern.empty() || from>=total) return;
+        refresh(document);
+        size_t overlap=pattern.size()-1;
+        bool filtered=TextIndex::filters(pattern);
+        vector<uint64_t> candidates;
+        vector<uint32_t> patternTrigrams;
+        if(filtered){
+            candidates=trigrams.candidates(pattern);
+            sort(candidates.begin(), candidates.end());
+            for(size_t i=0;i+3<=pattern.size();i++){
+                patternTrigrams.push_back(TextIndex::trigramAt(pattern.data()+i));
+            }
+            sort(patternTrigrams.begin(), patternTrigrams.end());
+        }
+
+        bool more=true;
+        auto [chunk, at]=locate(from);
+        size_t start=from-at;
+        for(; more && chunk<chunks.size(); start+=chunks[chunk].size, chunk++){
+            size_t end=start+chunks[chunk].size;
+            size_t begin;
+            if(!filtered || binary_search(candidates.begin(), candidates.end(), chunks[chunk].key)){
+                begin=start;
+            } else if(chunk+1<chunks.size() && mayCross(chunk, patternTrigrams)){
+                // Only occurrences that run past the end can start here.
+                begin=max(start, end-min(end, overlap));
+            } else {
+                continue;
+            }
+            read(document, begin, end+overlap);
+            scanOccurrences(scratch, pattern, [&](size_t found){
+                size_t offset=begin+found;
+                if(offset>=end) return false;
+                if(offset>=from) more=fn(offset);
+                return more;
+            });
+        }
+    }
+};
+
+#endif
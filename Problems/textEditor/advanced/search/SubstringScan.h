@@ -0,0 +1,54 @@
+#ifndef SUBSTRING_SCAN_H
+#define SUBSTRING_SCAN_H
+
+#include<string_view>
+#include<cstring>
+#ifdef __SSE2__
+#include<emmintrin.h>
+#endif
+
+using namespace std;
+
+// Calls fn(offset) for every occurrence of needle in haystack, overlapping
+// ones included, in increasing order. Stops as soon as fn returns false and
+// returns false in that case.
+//
+// With SSE2, 16 candidate positions are tested at once by comparing the
+// needle's first and last bytes against two shifted loads; only positions
+// where both match are checked with memcmp. Without it, memchr finds the
+// candidates.
+template<typename F>
+bool scanOccurrences(string_view haystack, string_view needle, F fn){
+    size_t n=haystack.size();
+    size_t m=needle.size();
+    if(m==0 || m>n) return true;
+    const char* h=haystack.data();
+    const char* p=needle.data();
+    size_t i=0;
+
+#ifdef __SSE2__
+    const __m128i first=_mm_set1_epi8(p[0]);
+    const __m128i last=_mm_set1_epi8(p[m-1]);
+    for(; i+m-1+16<=n; i+=16){
+        __m128i a=_mm_loadu_si128((const __m128i*)(h+i));
+        __m128i b=_mm_loadu_si128((const __m128i*)(h+i+m-1));
+        unsigned mask=_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while(mask!=0){
+            unsigned bit=__builtin_ctz(mask);
+            if(memcmp(h+i+bit, p, m)==0 && !fn(i+bit)) return false;
+            mask&=mask-1;
+        }
+    }
+#endif
+
+    while(i+m<=n){
+        const char* hit=(const char*)memchr(h+i, p[0], n-m+1-i);
+        if(hit==nullptr) break;
+        i=hit-h;
+        if(memcmp(hit, p, m)==0 && !fn(i)) return false;
+        i++;
+    }
+    return true;
+}
+
+#endif
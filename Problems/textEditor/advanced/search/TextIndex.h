@@ -0,0 +1,163 @@
+#ifndef TEXT_INDEX_H
+#define TEXT_INDEX_H
+
+#include<string_view>
+#include<vector>
+#include<unordered_map>
+#include<algorithm>
+#include<cstdint>
+
+using namespace std;
+
+// Trigram index over pieces of text, each known by a key the caller picks.
+// For every 3-byte sequence it keeps the ids of the pieces that contain it,
+// so a search only has to scan the pieces that contain all of the pattern's
+// trigrams.
+//
+// add() and remove() cost O(length of the piece). Removal is lazy: the
+// piece's id is marked dead and its posting entries are dropped in one pass
+// once dead entries outnumber live ones. Ids grow with every add, so each
+// posting list stays sorted and a key that is removed and added again with
+// new text never matches a stale entry.
+class TextIndex{
+private:
+    struct Slot{
+        uint64_t key;
+        uint32_t trigrams;
+        bool live;
+    };
+
+    vector<Slot> slots;
+    unordered_map<uint64_t, uint32_t> ids;
+    unordered_map<uint32_t, vector<uint32_t>> postings;
+    size_t livePostings=0;
+    size_t deadPostings=0;
+
+    // One bit per possible trigram, used to add each trigram of a piece
+    // once; only the bits that were set are cleared again.
+    vector<uint64_t> seen;
+    vector<uint32_t> touched;
+
+    void compact(){
+        vector<uint32_t> renumbered(slots.size());
+        vector<Slot> kept;
+        for(size_t id=0;id<slots.size();id++){
+            if(!slots[id].live) continue;
+            renumbered[id]=kept.size();
+            ids[slots[id].key]=kept.size();
+            kept.push_back(slots[id]);
+        }
+        for(auto it=postings.begin();it!=postings.end();){
+            vector<uint32_t>& list=it->second;
+            size_t out=0;
+            for(uint32_t id : list){
+                if(slots[id].live) list[out++]=renumbered[id];
+            }
+            list.resize(out);
+            if(list.empty()){
+                it=postings.erase(it);
+            } else {
+                list.shrink_to_fit();
+                ++it;
+            }
+        }
+        slots.swap(kept);
+        deadPostings=0;
+    }
+
+public:
+    // Indexes contents under key, unless key is already indexed.
+    void add(uint64_t key, string_view contents){
+        if(ids.count(key)) return;
+        uint32_t id=slots.size();
+        if(seen.empty()) seen.assign((1<<24)/64, 0);
+        for(size_t i=0;i+3<=contents.size();i++){
+            uint32_t trigram=trigramAt(contents.data()+i);
+            uint64_t bit=uint64_t(1)<<(trigram%64);
+            if(seen[trigram/64]&bit) continue;
+            seen[trigram/64]|=bit;
+            touched.push_back(trigram);
+            postings[trigram].push_back(id);
+        }
+        for(uint32_t trigram : touched){
+            seen[trigram/64]=0;
+        }
+        // Pieces shorter than a trigram are never candidates, so they need
+        // no slot.
+        if(!touched.empty()){
+            slots.push_back({key, (uint32_t)touched.size(), true});
+            ids[key]=id;
+            livePostings+=touched.size();
+            touched.clear();
+        }
+    }
+
+    void remove(uint64_t key){
+        auto it=ids.find(key);
+        if(it==ids.end()) return;
+        Slot& slot=slots[it->second];
+        slot.live=false;
+        livePostings-=slot.trigrams;
+        deadPostings+=slot.trigrams;
+        ids.erase(it);
+        if(deadPostings>livePostings) compact();
+    }
+
+    void clear(){
+        slots.clear();
+        ids.clear();
+        postings.clear();
+        livePostings=0;
+        deadPostings=0;
+    }
+
+    // The trigram starting at text, as the index numbers it.
+    static uint32_t trigramAt(const char* text){
+        return (uint32_t)(unsigned char)text[0]<<16 | (uint32_t)(unsigned char)text[1]<<8 | (unsigned char)text[2];
+    }
+
+    // Whether candidates() can narrow the search for pattern; patterns
+    // shorter than a trigram can occur in any piece.
+    static bool filters(string_view pattern){
+        return pattern.size()>=3;
+    }
+
+    // Keys of the pieces that contain every trigram of pattern, i.e. the
+    // only ones pattern can occur in. Requires filters(pattern).
+    vector<uint64_t> candidates(string_view pattern) const{
+        vector<const vector<uint32_t>*> lists;
+        for(size_t i=0;i+3<=pattern.size();i++){
+            auto it=postings.find(trigramAt(pattern.data()+i));
+            if(it==postings.end()) return {};
+            lists.push_back(&it->second);
+        }
+        sort(lists.begin(), lists.end());
+        lists.erase(unique(lists.begin(), lists.end()), lists.end());
+        sort(lists.begin(), lists.end(), [](const vector<uint32_t>* a, const vector<uint32_t>* b){
+            return a->size()<b->size();
+        });
+
+        // Start from the shortest list and probe the others by binary search,
+        // so common trigrams cost little.
+        vector<uint32_t> matches;
+        for(uint32_t id : *lists[0]){
+            if(slots[id].live) matches.push_back(id);
+        }
+        for(size_t l=1;l<lists.size() && !matches.empty();l++){
+            const vector<uint32_t>& list=*lists[l];
+            size_t out=0;
+            for(uint32_t id : matches){
+                if(binary_search(list.begin(), list.end(), id)) matches[out++]=id;
+            }
+            matches.resize(out);
+        }
+
+        vector<uint64_t> result;
+        for(uint32_t id : matches){
+            result.push_back(slots[id].key);
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef COMPRESSED_FILE_STORAGE_H
+#define COMPRESSED_FILE_STORAGE_H
+
+#include<iostream>
+#include<string>
+#include<string_view>
+#include<vector>
+#include<cstring>
+#include<cstddef>
+#include<cstdint>
+#include<algorithm>
+#include "Persistence.h"
+#include "FileSink.h"
+#include "MappedFile.h"
+#include "LzCodec.h"
+#include "Crc32.h"
+
+using namespace std;
+
+// Saves documents compressed, as independent blocks of LzCodec::maxBlock
+// bytes followed by an index of the blocks, so a range of the document can
+// be read by decoding only the blocks it overlaps:
+//
+//   FileHeader | block 0 | block 1 | ... | BlockEntry[blockCount] | Footer
+//
+// A block that does not shrink is stored as is. Each entry records where its
+// block starts, its stored and raw sizes and a CRC-32 of the raw bytes. The
+// footer's CRC-32 covers the index and the footer fields before it, and a
+// file is only read if its block sizes add up to the footer's raw length with
+// every block but the last one full, so offsets map to blocks exactly.
+class CompressedFileStorage: public Persistence{
+private:
+    static const uint32_t fileMagic=0x43445a4c;  // "LZDC"
+
+    struct FileHeader{
+        uint32_t magic;
+        uint32_t blockSize;
+    };
+
+    struct BlockEntry{
+        uint64_t offset;
+        uint32_t storedSize;
+        uint32_t rawSize;
+        uint32_t crc;
+        uint32_t reserved;
+    };
+
+    struct Footer{
+        uint64_t indexOffset;
+        uint64_t blockCount;
+        uint64_t rawLength;
+        // Of the index, then of the three fields above.
+        uint32_t crc;
+        uint32_t magic;
+    };
+
+    static uint32_t footerCrc(const BlockEntry* index, const Footer& footer){
+        uint32_t crc=crc32(index, footer.blockCount*sizeof(BlockEntry));
+        return crc32(&footer, offsetof(Footer, crc), crc);
+    }
+
+    // Cuts whatever is rendered into it into blocks and writes each one
+    // compressed, then the index and footer on finish().
+    class BlockSink: public RenderSink{
+    private:
+        FileSink& file;
+        string pending;
+        string packed;
+        vector<BlockEntry> index;
+        uint64_t offset=sizeof(FileHeader);
+        uint64_t rawLength=0;
+
+        void emitBlock(){
+            packed.clear();
+            BlockEntry entry={offset, 0, (uint32_t)pending.size(), crc32(pending.data(), pending.size()), 0};
+            string_view stored=pending;
+            if(LzCodec::compress(pending, packed)) stored=packed;
+            entry.storedSize=stored.size();
+            file.write(stored.data(), stored.size());
+            index.push_back(entry);
+            offset+=stored.size();
+            rawLength+=pending.size();
+            pending.clear();
+        }
+
+    public:
+        BlockSink(FileSink& file): file(file){
+            pending.reserve(LzCodec::maxBlock);
+            FileHeader header={fileMagic, (uint32_t)LzCodec::maxBlock};
+            file.write((const char*)&header, sizeof(header));
+        }
+
+        void write(const char* data, size_t size) override{
+            while(size>0){
+                size_t take=min(size, LzCodec::maxBlock-pending.size());
+                pending.append(data, take);
+                data+=take;
+                size-=take;
+                if(pending.size()==LzCodec::maxBlock) emitBlock();
+            }
+        }
+
+        void finish(){
+            if(!pending.empty()) emitBlock();
+            size_t indexBytes=index.size()*sizeof(BlockEntry);
+            Footer footer={offset, index.size(), rawLength, 0, fileMagic};
+            footer.crc=footerCrc(index.data(), footer);
+            file.write((const char*)index.data(), indexBytes);
+            file.write((const char*)&footer, sizeof(footer));
+        }
+    };
+
+    string path;
+    bool durable;
+
+    template<typename Render>
+    void saveBlocks(Render render){
+        FileSink file(path, durable);
+        if(!file.ok()){
+            cout << "Error: Unable to open file for writing." << endl;
+            return;
+        }
+        BlockSink blocks(file);
+        render(blocks);
+        blocks.finish();
+        if(file.close()){
+            cout << "Document saved to " << path << endl;
+        } else {
+            cout << "Error: Failed while writing " << path << endl;
+        }
+    }
+
+    static bool readIndex(string_view file, vector<BlockEntry>& index, uint64_t& rawLength){
+        if(file.size()<sizeof(FileHeader)+sizeof(Footer)) return false;
+        FileHeader header;
+        Footer footer;
+        memcpy(&header, file.data(), sizeof(header));
+        memcpy(&footer, file.data()+file.size()-sizeof(footer), sizeof(footer));
+        if(header.magic!=fileMagic || footer.magic!=fileMagic || header.blockSize!=LzCodec::maxBlock) return false;
+        uint64_t indexEnd=file.size()-sizeof(footer);
+        if(footer.indexOffset>indexEnd || footer.blockCount!=(indexEnd-footer.indexOffset)/sizeof(BlockEntry)) return false;
+        index.resize(footer.blockCount);
+        memcpy(index.data(), file.data()+footer.indexOffset, footer.blockCount*sizeof(BlockEntry));
+        if(footerCrc(index.data(), footer)!=footer.crc) return false;
+        uint64_t sum=0;
+        for(size_t i=0;i<index.size();i++){
+            bool last=i+1==index.size();
+            if(last ? index[i].rawSize==0 || index[i].rawSize>LzCodec::maxBlock : index[i].rawSize!=LzCodec::maxBlock) return false;
+            sum+=index[i].rawSize;
+        }
+        if(sum!=footer.rawLength) return false;
+        rawLength=footer.rawLength;
+        return true;
+    }
+
+    // Decodes one block into out, which has room for entry.rawSize bytes.
+    static bool readBlock(string_view file, const BlockEntry& entry, char* out){
+        if(entry.offset>file.size() || entry.storedSize>file.size()-entry.offset) return false;
+        string_view stored=file.substr(entry.offset, entry.storedSize);
+        if(entry.storedSize==entry.rawSize){
+            memcpy(out, stored.data(), stored.size());
+        } else if(!LzCodec::decompress(stored, out, entry.rawSize)){
+            return false;
+        }
+        return crc32(out, entry.rawSize)==entry.crc;
+    }
+
+public:
+    CompressedFileStorage(const string& path="document.lz", bool durable=false){
+        this->path=path;
+        this->durable=durable;
+    }
+
+    void save(const string& data) override{
+        saveBlocks([&](RenderSink& sink){ sink.write(data.data(), data.size()); });
+    }
+
+    void saveDocument(const Document::Snapshot& document) override{
+        saveBlocks([&](RenderSink& sink){ document.renderTo(sink); });
+    }
+
+    // Decodes the whole document. Returns false if the file is missing or
+    // damaged.
+    bool load(string& out) const{
+        return read(0, SIZE_MAX, out);
+    }
+
+    // Decodes only bytes [offset, offset + length) of the document, touching
+    // just the blocks that hold them; a range past the end is cut short.
+    bool read(uint64_t offset, size_t length, string& out) const{
+        out.clear();
+        MappedFile mapped(path);
+        if(!mapped.ok()) return false;
+        string_view file=mapped.contents();
+        vector<BlockEntry> index;
+        uint64_t rawLength;
+        if(!readIndex(file, index, rawLength)) return false;
+        if(offset>=rawLength) return true;
+        uint64_t end=offset+min<uint64_t>(length, rawLength-offset);
+        out.reserve(end-offset);
+
+        string block(LzCodec::maxBlock, '\0');
+        uint64_t blockStart=(offset/LzCodec::maxBlock)*LzCodec::maxBlock;
+        for(size_t i=offset/LzCodec::maxBlock; i<index.size() && blockStart<end; i++){
+            const BlockEntry& entry=index[i];
+            if(!readBlock(file, entry, &block[0])) return false;
+            uint64_t from=max(offset, blockStart)-blockStart;
+            uint64_t to=min<uint64_t>(end-blockStart, entry.rawSize);
+            if(from<to) out.append(block.data()+from, to-from);
+            blockStart+=entry.rawSize;
+        }
+        return out.size()==end-offset;
+    }
+};
+
+#endif
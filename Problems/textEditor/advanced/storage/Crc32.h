@@ -0,0 +1,41 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include<cstdint>
+#include<cstddef>
+
+// CRC-32 (IEEE 802.3, the polynomial used by zip and PNG). Pass the previous
+// result as crc to checksum data that arrives in pieces.
+inline uint32_t crc32(const void* data, size_t size, uint32_t crc=0){
+    // Slicing-by-8: eight tables let the loop fold in eight bytes per step.
+    static const struct Table{
+        uint32_t entries[8][256];
+        Table(){
+            for(uint32_t i=0;i<256;i++){
+                uint32_t c=i;
+                for(int k=0;k<8;k++) c=(c&1) ? 0xEDB88320u^(c>>1) : c>>1;
+                entries[0][i]=c;
+            }
+            for(uint32_t i=0;i<256;i++){
+                for(int t=1;t<8;t++){
+                    entries[t][i]=(entries[t-1][i]>>8)^entries[0][entries[t-1][i]&0xFF];
+                }
+            }
+        }
+    } table;
+    const unsigned char* bytes=static_cast<const unsigned char*>(data);
+    crc=~crc;
+    for(;size>=8;size-=8, bytes+=8){
+        uint32_t low=(bytes[0] | bytes[1]<<8 | bytes[2]<<16 | (uint32_t)bytes[3]<<24)^crc;
+        crc=table.entries[7][low&0xFF]^table.entries[6][(low>>8)&0xFF]^
+            table.entries[5][(low>>16)&0xFF]^table.entries[4][low>>24]^
+            table.entries[3][bytes[4]]^table.entries[2][bytes[5]]^
+            table.entries[1][bytes[6]]^table.entries[0][bytes[7]];
+    }
+    for(;size>0;size--, bytes++){
+        crc=table.entries[0][(crc^*bytes)&0xFF]^(crc>>8);
+    }
+    return ~crc;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef DB_PERSISTENCE_H
+#define DB_PERSISTENCE_H
+
+#include<string>
+#include "Persistence.h"
+#include "DocumentStore.h"
+
+using namespace std;
+
+// Saves one document, under documentId, into a shared DocumentStore. Saves
+// are handed to the store's background writer, so the editor never waits
+// on the disk.
+class DBPersistence: public Persistence{
+private:
+    DocumentStore* store;
+    string documentId;
+
+public:
+    DBPersistence(DocumentStore* store, const string& documentId){
+        this->store=store;
+        this->documentId=documentId;
+    }
+
+    void save(const string& data) override{
+        store->put(documentId, data);
+    }
+
+    void saveDocument(const Document::Snapshot& document) override{
+        store->put(documentId, document.render());
+    }
+};
+
+#endif
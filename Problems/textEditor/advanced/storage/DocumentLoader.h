@@ -0,0 +1,37 @@
+#ifndef DOCUMENT_LOADER_H
+#define DOCUMENT_LOADER_H
+
+#include<iostream>
+#include<string>
+#include<memory>
+#include "MappedFile.h"
+#include "../models/Document.h"
+
+using namespace std;
+
+// Opens a saved document by mapping it and cutting it into fixed-size
+// TextElements that point into the mapping. Nothing is read or copied up
+// front, so opening is O(file size / blockSize) and costs no resident memory
+// until pages are touched; an element is copied to the heap only when it is
+// edited (see DocumentEditor::editText).
+class DocumentLoader{
+public:
+    static const size_t blockSize=256*1024;
+
+    static bool load(const string& path, Document& document){
+        shared_ptr<MappedFile> file=make_shared<MappedFile>(path);
+        if(!file->ok()){
+            cout << "Error: Unable to open " << path << " for reading." << endl;
+            return false;
+        }
+        string_view contents=file->contents();
+        for(size_t offset=0; offset<contents.size(); offset+=blockSize){
+            string_view block=contents.substr(offset, blockSize);
+            document.addElement(document.arena().makeText(BorrowedText{block}));
+        }
+        document.retain(file);
+        return true;
+    }
+};
+
+#endif
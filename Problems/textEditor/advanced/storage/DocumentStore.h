@@ -0,0 +1,470 @@
+#ifndef DOCUMENT_STORE_H
+#define DOCUMENT_STORE_H
+
+#include<iostream>
+#include<string>
+#include<vector>
+#include<deque>
+#include<memory>
+#include<unordered_map>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<chrono>
+#include<cstring>
+#include<cstddef>
+#include<cstdint>
+#include<cerrno>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/stat.h>
+#include "Crc32.h"
+
+using namespace std;
+
+// Small embedded key-value store for whole documents, kept in one
+// append-only file. put() only queues the value: a background writer takes
+// everything queued, writes it with one write() and makes it durable with one
+// fdatasync() (group commit). Saving a document that is already queued
+// replaces the queued copy, so a burst of autosaves of the same document
+// costs one write. The queue holds at most maxPending distinct documents;
+// only past that does put() wait for the writer.
+//
+// An in-memory index maps each key to its latest record and is rebuilt by
+// scanning the file on open. A torn group commit at the end is cut off; a
+// damaged record elsewhere is skipped with a warning and the records after it
+// are kept. get() sees a value from the moment put() returns: queued, being
+// written, or indexed.
+//
+// A batch whose write or fdatasync() fails goes back to the front of the
+// queue, except keys that a newer put() replaced meanwhile, and the writer
+// retries it every retryDelay. flush() reports whether its saves reached the
+// disk.
+//
+// Every save of a document leaves its previous record behind as dead space.
+// Once the dead bytes pass compactAfter and outweigh the live ones, the
+// writer copies the live records into a new file and renames it over the
+// old one, so the file stays within about twice the live data. Reads that
+// are under way keep the old file open until they finish.
+class DocumentStore{
+private:
+    static const uint32_t recordMagic=0x52434f44;  // "DOCR"
+    static constexpr chrono::milliseconds retryDelay{100};
+
+    // crc covers keyLength, valueLength, the key and the value.
+    struct RecordHeader{
+        uint32_t magic;
+        uint32_t crc;
+        uint32_t keyLength;
+        uint32_t reserved;
+        uint64_t valueLength;
+    };
+
+    struct Location{
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    // One generation of the data file; compaction replaces it.
+    struct DataFile{
+        int fd;
+
+        DataFile(int fd): fd(fd){}
+        DataFile(const DataFile&)=delete;
+        DataFile& operator=(const DataFile&)=delete;
+
+        ~DataFile(){
+            if(fd>=0) ::close(fd);
+        }
+    };
+
+    string path;
+    shared_ptr<DataFile> file;
+    uint64_t fileSize=0;
+    uint64_t liveBytes=0;
+    size_t maxPending;
+    size_t compactAfter;
+
+    mutex mtx;
+    condition_variable hasWork;
+    condition_variable hasRoom;
+    condition_variable committed;
+    unordered_map<string, string> pending;
+    deque<string> order;
+    // The batch the writer is writing; its keys are not indexed yet.
+    unordered_map<string, string> inFlight;
+    unordered_map<string, Location> index;
+    uint64_t queuedSaves=0;
+    // Saves covered by the last commit attempt, and by the last one that
+    // reached the disk.
+    uint64_t attemptedSaves=0;
+    uint64_t durableSaves=0;
+    bool stopping=false;
+    // The last commit failed; cleared by the next one that succeeds.
+    bool failed=false;
+    bool compactRequested=false;
+    thread writer;
+
+    size_t coalesced=0;
+    size_t batches=0;
+    size_t compactions=0;
+    size_t compactionRuns=0;
+
+    static uint32_t checksum(const RecordHeader& header, const string& key, const char* value, size_t size){
+        uint32_t crc=crc32(&header.keyLength, sizeof(header)-offsetof(RecordHeader, keyLength));
+        crc=crc32(key.data(), key.size(), crc);
+        return crc32(value, size, crc);
+    }
+
+    static uint64_t recordSize(const string& key, uint64_t valueLength){
+        return sizeof(RecordHeader)+key.size()+valueLength;
+    }
+
+    // Appends the record for key and value to buffer, which will be written
+    // at fileOffset; returns where the value lands.
+    static Location appendRecord(string& buffer, uint64_t fileOffset, const string& key, const char* value, size_t size){
+        RecordHeader header={recordMagic, 0, (uint32_t)key.size(), 0, size};
+        header.crc=checksum(header, key, value, size);
+        Location location={fileOffset+buffer.size()+sizeof(header)+key.size(), size};
+        buffer.append((const char*)&header, sizeof(header));
+        buffer.append(key);
+        buffer.append(value, size);
+        return location;
+    }
+
+    // Points key at its new record and keeps liveBytes current.
+    void indexRecord(const string& key, Location location){
+        auto it=index.find(key);
+        if(it!=index.end()){
+            liveBytes-=recordSize(key, it->second.length);
+            it->second=location;
+        } else {
+            index.emplace(key, location);
+        }
+        liveBytes+=recordSize(key, location.length);
+    }
+
+    // Reads the record at pos if it is whole and its checksum matches. end is
+    // where the header says it stops, or 0 if there is no usable header.
+    static bool readRecord(int fd, uint64_t pos, uint64_t size, RecordHeader& header, string& key, string& value, uint64_t& end){
+        end=0;
+        if(size-pos<sizeof(header) || ::pread(fd, &header, sizeof(header), pos)!=(ssize_t)sizeof(header)) return false;
+        if(header.magic!=recordMagic) return false;
+        uint64_t body=size-pos-sizeof(header);
+        if(header.keyLength>body || header.valueLength>body-header.keyLength){
+            end=size+1;
+            return false;
+        }
+        end=pos+sizeof(header)+header.keyLength+header.valueLength;
+        key.resize(header.keyLength);
+        value.resize(header.valueLength);
+        if(::pread(fd, &key[0], key.size(), pos+sizeof(header))!=(ssize_t)key.size()) return false;
+        if(::pread(fd, &value[0], value.size(), pos+sizeof(header)+key.size())!=(ssize_t)value.size()) return false;
+        return checksum(header, key, value.data(), value.size())==header.crc;
+    }
+
+    // Start of the first whole record after a bad one at pos, or size if
+    // there is none. Where the bad record's header says it ends is tried
+    // first, so records stored inside a damaged value are not picked up.
+    static uint64_t findRecord(int fd, uint64_t pos, uint64_t end, uint64_t size){
+        RecordHeader header;
+        string key, value;
+        uint64_t next;
+        if(end>pos && end<size && readRecord(fd, end, size, header, key, value, next)) return end;
+        char block[1<<16];
+        for(uint64_t at=pos+1; at+sizeof(uint32_t)<=size;){
+            ssize_t n=::pread(fd, block, min<uint64_t>(sizeof(block), size-at), at);
+            if(n<(ssize_t)sizeof(uint32_t)) break;
+            for(size_t i=0;i+sizeof(uint32_t)<=(size_t)n;i++){
+                uint32_t magic;
+                memcpy(&magic, block+i, sizeof(magic));
+                if(magic==recordMagic && readRecord(fd, at+i, size, header, key, value, next)) return at+i;
+            }
+            at+=n-(sizeof(uint32_t)-1);
+        }
+        return size;
+    }
+
+    void loadIndex(){
+        int fd=file->fd;
+        struct stat info;
+        if(::fstat(fd, &info)!=0) return;
+        uint64_t size=info.st_size;
+        uint64_t pos=0;
+        RecordHeader header;
+        string key, value;
+        uint64_t end;
+        while(pos<size){
+            if(readRecord(fd, pos, size, header, key, value, end)){
+                indexRecord(key, {pos+sizeof(header)+key.size(), header.valueLength});
+                pos=end;
+                continue;
+            }
+            // Group commits only append, so a crash can only tear the end of
+            // the file. Anything followed by a whole record is damage, and
+            // the records after it are kept.
+            uint64_t next=findRecord(fd, pos, end, size);
+            if(next==size){
+                if(::ftruncate(fd, pos)!=0) cout << "Error: Unable to truncate " << path << endl;
+                size=pos;
+                break;
+            }
+            cout << "Warning: skipped " << next-pos << " damaged bytes at offset " << pos << " of " << path << endl;
+            pos=next;
+        }
+        fileSize=size;
+    }
+
+    void writeLoop(){
+        unique_lock<mutex> lock(mtx);
+        while(true){
+            hasWork.wait(lock, [&]{ return stopping || !order.empty() || compactRequested; });
+            if(!order.empty()) writeBatch(lock);
+            if(compactRequested || needsCompaction()) compactFile(lock);
+            // A store that cannot write gives up on what is left once closing.
+            if(stopping && (order.empty() || failed)) return;
+            if(failed) hasWork.wait_for(lock, retryDelay, [&]{ return stopping; });
+        }
+    }
+
+    // Writes everything queued as one group commit. Called with lock held;
+    // drops it around the write.
+    void writeBatch(unique_lock<mutex>& lock){
+        inFlight.swap(pending);
+        vector<string> keys(make_move_iterator(order.begin()), make_move_iterator(order.end()));
+        order.clear();
+        uint64_t upTo=queuedSaves;
+        hasRoom.notify_all();
+        shared_ptr<DataFile> data=file;
+        uint64_t offset=fileSize;
+        lock.unlock();
+
+        // Only this thread changes inFlight, so it can read it unlocked.
+        string buffer;
+        vector<Location> written;
+        for(const string& key : keys){
+            const string& value=inFlight.find(key)->second;
+            written.push_back(appendRecord(buffer, offset, key, value.data(), value.size()));
+        }
+        bool ok=writeAt(data->fd, buffer.data(), buffer.size(), offset) && ::fdatasync(data->fd)==0;
+        if(!ok){
+            if(!failed) cout << "Error: Unable to write to " << path << ", retrying" << endl;
+            // Cut a partial write, so the retry does not leave its end behind.
+            if(data->fd>=0) (void)::ftruncate(data->fd, offset);
+        }
+
+        lock.lock();
+        if(ok){
+            fileSize=offset+buffer.size();
+            for(size_t i=0;i<keys.size();i++){
+                indexRecord(keys[i], written[i]);
+            }
+            durableSaves=upTo;
+            failed=false;
+        } else {
+            // Queue the batch again ahead of newer keys; a key put again
+            // meanwhile already has its newer value queued.
+            failed=true;
+            vector<string> retry;
+            for(string& key : keys){
+                if(pending.count(key)) continue;
+                pending.emplace(key, move(inFlight.find(key)->second));
+                retry.push_back(move(key));
+            }
+            order.insert(order.begin(), make_move_iterator(retry.begin()), make_move_iterator(retry.end()));
+        }
+        inFlight.clear();
+        batches++;
+        attemptedSaves=upTo;
+        committed.notify_all();
+    }
+
+    bool needsCompaction() const{
+        uint64_t dead=fileSize-liveBytes;
+        return !failed && dead>=compactAfter && dead>liveBytes;
+    }
+
+    // Copies the live records into path.compact and renames it over path.
+    // Called with lock held; drops it while copying. Nothing else writes to
+    // the file or the index meanwhile, since only this thread does.
+    void compactFile(unique_lock<mutex>& lock){
+        compactRequested=false;
+        compactionRuns++;
+        if(failed){
+            committed.notify_all();
+            return;
+        }
+        vector<pair<string, Location>> live(index.begin(), index.end());
+        shared_ptr<DataFile> old=file;
+        lock.unlock();
+
+        string tempPath=path+".compact";
+        int fd=::open(tempPath.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+        bool ok=fd>=0;
+        vector<Location> moved;
+        string buffer, value;
+        uint64_t written=0;
+        for(size_t i=0;ok && i<live.size();i++){
+            const Location& location=live[i].second;
+            value.resize(location.length);
+            if(location.length>0 && ::pread(old->fd, &value[0], value.size(), location.offset)!=(ssize_t)value.size()){
+                ok=false;
+                break;
+            }
+            moved.push_back(appendRecord(buffer, written, live[i].first, value.data(), value.size()));
+            if(buffer.size()>=(1<<20) || i+1==live.size()){
+                ok=writeAt(fd, buffer.data(), buffer.size(), written);
+                written+=buffer.size();
+                buffer.clear();
+            }
+        }
+        ok=ok && ::fdatasync(fd)==0 && ::rename(tempPath.c_str(), path.c_str())==0;
+        if(ok){
+            syncDirectory();
+        } else {
+            if(fd>=0) ::close(fd);
+            ::unlink(tempPath.c_str());
+        }
+
+        lock.lock();
+        if(ok){
+            file=make_shared<DataFile>(fd);
+            index.clear();
+            for(size_t i=0;i<live.size();i++){
+                index.emplace(move(live[i].first), moved[i]);
+            }
+            fileSize=written;
+            liveBytes=written;
+            compactions++;
+        }
+        committed.notify_all();
+    }
+
+    void syncDirectory(){
+        size_t slash=path.rfind('/');
+        string dir=slash==string::npos ? "." : path.substr(0, slash+1);
+        int fd=::open(dir.c_str(), O_RDONLY);
+        if(fd>=0){
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    static bool writeAt(int fd, const char* data, size_t size, uint64_t offset){
+        while(size>0){
+            ssize_t n=::pwrite(fd, data, size, offset);
+            if(n<0){
+                if(errno==EINTR) continue;
+                return false;
+            }
+            data+=n;
+            size-=n;
+            offset+=n;
+        }
+        return true;
+    }
+
+public:
+    DocumentStore(const string& path="documents.db", size_t maxPending=1024, size_t compactAfter=64<<20){
+        this->path=path;
+        this->maxPending=maxPending;
+        this->compactAfter=compactAfter;
+        file=make_shared<DataFile>(::open(path.c_str(), O_RDWR|O_CREAT, 0644));
+        if(file->fd<0){
+            failed=true;
+        } else {
+            loadIndex();
+        }
+        writer=thread(&DocumentStore::writeLoop, this);
+    }
+
+    DocumentStore(const DocumentStore&)=delete;
+    DocumentStore& operator=(const DocumentStore&)=delete;
+
+    // Writes out everything still queued before closing.
+    ~DocumentStore(){
+        {
+            lock_guard<mutex> lock(mtx);
+            stopping=true;
+        }
+        hasWork.notify_one();
+        writer.join();
+    }
+
+    // Queues value under key and returns without touching the disk.
+    void put(const string& key, string value){
+        unique_lock<mutex> lock(mtx);
+        queuedSaves++;
+        auto it=pending.find(key);
+        if(it!=pending.end()){
+            it->second=move(value);
+            coalesced++;
+            return;
+        }
+        hasRoom.wait(lock, [&]{ return pending.size()<maxPending; });
+        pending.emplace(key, move(value));
+        order.push_back(key);
+        hasWork.notify_one();
+    }
+
+    // Latest value for key, including saves that are still queued or being
+    // written.
+    bool get(const string& key, string& value){
+        unique_lock<mutex> lock(mtx);
+        for(const auto* queued : {&pending, &inFlight}){
+            auto it=queued->find(key);
+            if(it!=queued->end()){
+                value=it->second;
+                return true;
+            }
+        }
+        auto it=index.find(key);
+        if(it==index.end()) return false;
+        Location location=it->second;
+        shared_ptr<DataFile> data=file;
+        lock.unlock();
+        value.resize(location.length);
+        return location.length==0 ||
+               ::pread(data->fd, &value[0], location.length, location.offset)==(ssize_t)location.length;
+    }
+
+    // Blocks until every put() made before the call has been written once;
+    // returns false if they are not all on disk yet because that write
+    // failed. The writer keeps retrying them.
+    bool flush(){
+        unique_lock<mutex> lock(mtx);
+        uint64_t target=queuedSaves;
+        committed.wait(lock, [&]{ return attemptedSaves>=target; });
+        return durableSaves>=target;
+    }
+
+    // Writes out what is queued, then compacts the file now and waits for
+    // it; returns false if that failed.
+    bool compact(){
+        unique_lock<mutex> lock(mtx);
+        size_t runs=compactionRuns;
+        size_t done=compactions;
+        compactRequested=true;
+        hasWork.notify_one();
+        committed.wait(lock, [&]{ return compactionRuns!=runs; });
+        return compactions!=done;
+    }
+
+    // Bytes in the data file, dead records included.
+    uint64_t fileBytes(){
+        lock_guard<mutex> lock(mtx);
+        return fileSize;
+    }
+
+    size_t coalescedSaves(){
+        lock_guard<mutex> lock(mtx);
+        return coalesced;
+    }
+
+    size_t groupCommits(){
+        lock_guard<mutex> lock(mtx);
+        return batches;
+    }
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef FILE_SINK_H
+#define FILE_SINK_H
+
+#include<string>
+#include<vector>
+#include<cstring>
+#include<cerrno>
+#include<algorithm>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/uio.h>
+#include "../models/RenderSink.h"
+
+using namespace std;
+
+// Buffered, gathering file writer. Small pieces are copied into a fixed
+// buffer; large pieces passed through writeStable() are handed to writev() by
+// pointer, so the text is never copied. Memory stays bounded by the buffer and
+// the iovec batch however large the document is.
+//
+// Output goes to a temporary file that is renamed over path on close(), so a
+// document that is still mapped from path (see DocumentLoader) never sees its
+// file truncated underneath it.
+class FileSink: public RenderSink{
+private:
+    static const size_t bufferSize=64*1024;
+    static const size_t maxSegments=256;
+    static const size_t copyThreshold=256;
+
+    string path;
+    string tempPath;
+    int fd;
+    bool failed;
+    bool durable;
+    vector<char> buffer;
+    size_t used=0;
+    // Start of the buffered bytes not yet covered by an entry in segments.
+    size_t sealed=0;
+    vector<iovec> segments;
+
+    void sealBuffer(){
+        if(used>sealed){
+            segments.push_back({buffer.data()+sealed, used-sealed});
+            sealed=used;
+        }
+    }
+
+    void writeSegments(){
+        iovec* iov=segments.data();
+        size_t count=segments.size();
+        while(count>0 && !failed){
+            ssize_t n=::writev(fd, iov, (int)count);
+            if(n<0){
+                if(errno==EINTR) continue;
+                failed=true;
+                break;
+            }
+            size_t written=n;
+            while(count>0 && written>=iov->iov_len){
+                written-=iov->iov_len;
+                iov++;
+                count--;
+            }
+            if(count>0){
+                iov->iov_base=(char*)iov->iov_base+written;
+                iov->iov_len-=written;
+            }
+        }
+    }
+
+public:
+    // With durable set, the data is flushed to disk before the rename, so a
+    // crash leaves either the old file or the complete new one.
+    FileSink(const string& path, bool durable=false){
+        this->durable=durable;
+        this->path=path;
+        this->tempPath=path+".tmp";
+        fd=::open(tempPath.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        failed=fd<0;
+        buffer.resize(bufferSize);
+        segments.reserve(maxSegments);
+    }
+
+    FileSink(const FileSink&)=delete;
+    FileSink& operator=(const FileSink&)=delete;
+
+    ~FileSink(){
+        close();
+    }
+
+    bool ok() const{
+        return !failed;
+    }
+
+    void write(const char* data, size_t size) override{
+        while(size>0){
+            if(used==bufferSize) flush();
+            size_t n=min(size, bufferSize-used);
+            memcpy(buffer.data()+used, data, n);
+            used+=n;
+            data+=n;
+            size-=n;
+        }
+    }
+
+    void writeStable(const char* data, size_t size) override{
+        if(size<copyThreshold){
+            write(data, size);
+            return;
+        }
+        sealBuffer();
+        segments.push_back({(void*)data, size});
+        // Leave room for the buffer segment flush() may still add.
+        if(segments.size()+1>=maxSegments) flush();
+    }
+
+    void flush(){
+        if(fd<0) return;
+        sealBuffer();
+        writeSegments();
+        segments.clear();
+        used=0;
+        sealed=0;
+    }
+
+    // Flushes, closes and renames the file into place; returns false (and
+    // leaves path untouched) if any step failed.
+    bool close(){
+        if(fd>=0){
+            flush();
+            if(durable && !failed && ::fsync(fd)!=0) failed=true;
+            if(::close(fd)!=0) failed=true;
+            fd=-1;
+            if(failed || ::rename(tempPath.c_str(), path.c_str())!=0){
+                failed=true;
+                ::unlink(tempPath.c_str());
+            }
+        }
+        return !failed;
+    }
+};
+
+#endif
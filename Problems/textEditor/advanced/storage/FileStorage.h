@@ -0,0 +1,48 @@
+#ifndef FILE_STORAGE_H
+#define FILE_STORAGE_H
+
+#include<iostream>
+#include<fstream>
+#include<string>
+#include "Persistence.h"
+#include "FileSink.h"
+
+using namespace std;
+
+class FileStorage: public Persistence{
+private:
+    string path;
+
+public:
+    FileStorage(const string& path="document.txt"){
+        this->path=path;
+    }
+
+    void save(const string& data) override{
+        ofstream outFile(path);
+        if (outFile) {
+            outFile << data;
+            outFile.close();
+            cout << "Document saved to " << path << endl;
+        } else {
+            cout << "Error: Unable to open file for writing." << endl;
+        }
+    }
+
+    // Renders element by element straight into the file.
+    void saveDocument(const Document::Snapshot& document) override{
+        FileSink sink(path);
+        if (!sink.ok()) {
+            cout << "Error: Unable to open file for writing." << endl;
+            return;
+        }
+        document.renderTo(sink);
+        if (sink.close()) {
+            cout << "Document saved to " << path << endl;
+        } else {
+            cout << "Error: Failed while writing " << path << endl;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef JOURNALED_FILE_STORAGE_H
+#define JOURNALED_FILE_STORAGE_H
+
+#include<iostream>
+#include<string>
+#include<string_view>
+#include<vector>
+#include<thread>
+#include<atomic>
+#include<mutex>
+#include<cstring>
+#include<cstddef>
+#include<cstdint>
+#include<algorithm>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/stat.h>
+#include "Persistence.h"
+#include "FileSink.h"
+#include "Crc32.h"
+
+using namespace std;
+
+// Crash-safe storage that writes only what changed. A full save writes a
+// base file (path.base); every later save appends the editor's TextChanges
+// to a journal (path.journal) as checksummed records and fsyncs it, so a save
+// costs O(size of the edits).
+//
+// Once the journal passes compactAfter bytes it is sealed (renamed to
+// path.journal.old) and a fresh one is started; a background thread folds the
+// sealed journal into a new base and renames it into place. Records carry
+// increasing sequence numbers and the base remembers the last one it
+// contains, so a crash at any point replays each change exactly once, and a
+// torn record at the end of a journal is detected by its checksum and
+// dropped.
+//
+// Saves may come from an editor's saver thread while compact() or load() is
+// called from another; stateLock serialises them.
+class JournaledFileStorage: public Persistence{
+private:
+    static const uint32_t baseMagic=0x45534142;    // "BASE"
+    static const uint32_t recordMagic=0x4c4e524a;  // "JRNL"
+
+    struct BaseHeader{
+        uint32_t magic;
+        uint32_t reserved;
+        uint64_t seq;
+    };
+
+    // crc covers every field after it plus the record's text. The last
+    // record written by one save is flagged endOfSave; recovery only applies
+    // complete saves.
+    struct RecordHeader{
+        uint32_t magic;
+        uint32_t crc;
+        uint64_t seq;
+        uint64_t offset;
+        uint64_t erased;
+        uint32_t length;
+        uint32_t endOfSave;
+    };
+
+    static const size_t checkedHeaderBytes=sizeof(RecordHeader)-offsetof(RecordHeader, seq);
+
+    string basePath;
+    string journalPath;
+    string sealedPath;
+    size_t compactAfter;
+    // Guards the journal descriptor, the sequence numbers and the compactor
+    // thread object. The compactor itself only touches files.
+    mutex stateLock;
+    int journalFd=-1;
+    uint64_t nextSeq=1;
+    size_t journalBytes=0;
+    thread compactor;
+    atomic<bool> compacting{false};
+
+    static bool exists(const string& file){
+        struct stat info;
+        return ::stat(file.c_str(), &info)==0;
+    }
+
+    static bool readFile(const string& file, string& out){
+        int fd=::open(file.c_str(), O_RDONLY);
+        if(fd<0) return false;
+        out.clear();
+        char chunk[1<<16];
+        ssize_t n;
+        while((n=::read(fd, chunk, sizeof(chunk)))>0){
+            out.append(chunk, n);
+        }
+        ::close(fd);
+        return n==0;
+    }
+
+    static void syncDirectoryOf(const string& file){
+        size_t slash=file.rfind('/');
+        string dir=slash==string::npos ? "." : file.substr(0, slash+1);
+        int fd=::open(dir.c_str(), O_RDONLY);
+        if(fd>=0){
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    static bool writeAll(int fd, const char* data, size_t size){
+        while(size>0){
+            ssize_t n=::write(fd, data, size);
+            if(n<0){
+                if(errno==EINTR) continue;
+                return false;
+            }
+            data+=n;
+            size-=n;
+        }
+        return true;
+    }
+
+    // Loads the base into text and returns the last sequence number it holds.
+    uint64_t readBase(string& text) const{
+        string contents;
+        text.clear();
+        if(!readFile(basePath, contents) || contents.size()<sizeof(BaseHeader)) return 0;
+        BaseHeader header;
+        memcpy(&header, contents.data(), sizeof(header));
+        if(header.magic!=baseMagic) return 0;
+        text=contents.substr(sizeof(header));
+        return header.seq;
+    }
+
+    // Calls fn(header, text) for each record of every complete save, stopping
+    // at the first torn or corrupt record. Returns where the last complete
+    // save ends.
+    template<typename F>
+    static size_t scanJournal(const string& file, F fn){
+        string contents;
+        if(!readFile(file, contents)) return 0;
+        vector<pair<RecordHeader, string_view>> save;
+        size_t pos=0;
+        size_t complete=0;
+        while(pos+sizeof(RecordHeader)<=contents.size()){
+            RecordHeader header;
+            memcpy(&header, contents.data()+pos, sizeof(header));
+            if(header.magic!=recordMagic || header.length>contents.size()-pos-sizeof(header)) break;
+            string_view text(contents.data()+pos+sizeof(header), header.length);
+            uint32_t crc=crc32(contents.data()+pos+offsetof(RecordHeader, seq), checkedHeaderBytes);
+            if(crc32(text.data(), text.size(), crc)!=header.crc) break;
+            save.push_back({header, text});
+            pos+=sizeof(header)+header.length;
+            if(header.endOfSave){
+                for(auto& record : save) fn(record.first, record.second);
+                save.clear();
+                complete=pos;
+            }
+        }
+        return complete;
+    }
+
+    static void apply(string& text, const RecordHeader& header, string_view change){
+        size_t offset=min<size_t>(header.offset, text.size());
+        size_t erased=min<size_t>(header.erased, text.size()-offset);
+        text.replace(offset, erased, change.data(), change.size());
+    }
+
+    template<typename Write>
+    bool writeBase(uint64_t seq, Write write){
+        FileSink sink(basePath, true);
+        BaseHeader header={baseMagic, 0, seq};
+        sink.write((const char*)&header, sizeof(header));
+        write(sink);
+        if(!sink.close()) return false;
+        syncDirectoryOf(basePath);
+        return true;
+    }
+
+    // Cuts whatever follows the last complete save (a torn record, or the
+    // records of a save that never finished) off the journal, so the next
+    // save is appended right after it and replays with it.
+    void truncateJournal(size_t validBytes){
+        int fd=::open(journalPath.c_str(), O_WRONLY);
+        if(fd<0) return;
+        struct stat info;
+        if(::fstat(fd, &info)==0 && (size_t)info.st_size>validBytes){
+            if(::ftruncate(fd, validBytes)!=0 || ::fdatasync(fd)!=0){
+                cout << "Error: Unable to truncate " << journalPath << endl;
+            }
+        }
+        ::close(fd);
+    }
+
+    void openJournal(){
+        journalFd=::open(journalPath.c_str(), O_WRONLY|O_CREAT|O_APPEND, 0644);
+        struct stat info;
+        journalBytes=(journalFd>=0 && ::fstat(journalFd, &info)==0) ? info.st_size : 0;
+    }
+
+    // Folds the sealed journal into a new base. Runs on the compactor thread,
+    // without stateLock.
+    void compactSealed(){
+        string text;
+        uint64_t seq=readBase(text);
+        uint64_t last=seq;
+        scanJournal(sealedPath, [&](const RecordHeader& header, string_view change){
+            if(header.seq>seq){
+                apply(text, header, change);
+                last=header.seq;
+            }
+        });
+        if(writeBase(last, [&](RenderSink& sink){ sink.write(text.data(), text.size()); })){
+            ::unlink(sealedPath.c_str());
+            syncDirectoryOf(sealedPath);
+        }
+        compacting=false;
+    }
+
+    void startCompaction(){
+        if(compacting) return;
+        if(compactor.joinable()) compactor.join();
+        if(!exists(sealedPath)){
+            ::close(journalFd);
+            if(::rename(journalPath.c_str(), sealedPath.c_str())!=0){
+                openJournal();
+                return;
+            }
+            syncDirectoryOf(journalPath);
+            openJournal();
+        }
+        compacting=true;
+        compactor=thread(&JournaledFileStorage::compactSealed, this);
+    }
+
+    void waitForCompaction(){
+        if(compactor.joinable()) compactor.join();
+    }
+
+    // A full save supersedes every journaled change.
+    template<typename Write>
+    void saveBase(Write write){
+        lock_guard<mutex> guard(stateLock);
+        waitForCompaction();
+        uint64_t seq=nextSeq++;
+        if(!writeBase(seq, write)){
+            cout << "Error: Unable to write " << basePath << endl;
+            return;
+        }
+        ::unlink(sealedPath.c_str());
+        if(journalFd>=0 && ::ftruncate(journalFd, 0)==0) journalBytes=0;
+        cout << "Document saved to " << basePath << endl;
+    }
+
+public:
+    JournaledFileStorage(const string& path="document.txt", size_t compactAfter=64<<20){
+        this->basePath=path+".base";
+        this->journalPath=path+".journal";
+        this->sealedPath=path+".journal.old";
+        this->compactAfter=compactAfter;
+
+        string text;
+        uint64_t last=readBase(text);
+        size_t validBytes=0;
+        for(const string& journal : {sealedPath, journalPath}){
+            validBytes=scanJournal(journal, [&](const RecordHeader& header, string_view){
+                last=max<uint64_t>(last, header.seq);
+            });
+        }
+        nextSeq=last+1;
+        truncateJournal(validBytes);
+        openJournal();
+        // Finish a compaction that was interrupted by a crash.
+        if(exists(sealedPath)) startCompaction();
+    }
+
+    JournaledFileStorage(const JournaledFileStorage&)=delete;
+    JournaledFileStorage& operator=(const JournaledFileStorage&)=delete;
+
+    ~JournaledFileStorage(){
+        waitForCompaction();
+        if(journalFd>=0) ::close(journalFd);
+    }
+
+    void save(const string& data) override{
+        saveBase([&](RenderSink& sink){ sink.write(data.data(), data.size()); });
+    }
+
+    void saveDocument(const Document::Snapshot& document) override{
+        saveBase([&](RenderSink& sink){ document.renderTo(sink); });
+    }
+
+    bool supportsChanges() const override{
+        return true;
+    }
+
+    // Appends one record per change in a single write, then fsyncs.
+    bool saveChanges(const vector<TextChange>& changes) override{
+        if(changes.empty()) return true;
+        lock_guard<mutex> guard(stateLock);
+        string batch;
+        for(size_t i=0;i<changes.size();i++){
+            const TextChange& change=changes[i];
+            if(change.text.size()>UINT32_MAX) return false;
+            RecordHeader header={recordMagic, 0, nextSeq++, change.offset, change.erased,
+                                 (uint32_t)change.text.size(), i+1==changes.size()};
+            uint32_t crc=crc32((const char*)&header+offsetof(RecordHeader, seq), checkedHeaderBytes);
+            header.crc=crc32(change.text.data(), change.text.size(), crc);
+            batch.append((const char*)&header, sizeof(header));
+            batch.append(change.text);
+        }
+        if(journalFd<0 || !writeAll(journalFd, batch.data(), batch.size()) || ::fdatasync(journalFd)!=0){
+            cout << "Error: Unable to append to " << journalPath << endl;
+            return false;
+        }
+        journalBytes+=batch.size();
+        cout << "Journaled " << changes.size() << " change(s) to " << journalPath << endl;
+        if(journalBytes>compactAfter) startCompaction();
+        return true;
+    }
+
+    // Folds the journal into the base now and waits for it to finish.
+    void compact(){
+        lock_guard<mutex> guard(stateLock);
+        startCompaction();
+        waitForCompaction();
+    }
+
+    // Rebuilds the document text from the base and both journals.
+    string load(){
+        lock_guard<mutex> guard(stateLock);
+        waitForCompaction();
+        string text;
+        uint64_t seq=readBase(text);
+        for(const string& journal : {sealedPath, journalPath}){
+            scanJournal(journal, [&](const RecordHeader& header, string_view change){
+                if(header.seq>seq) apply(text, header, change);
+            });
+        }
+        return text;
+    }
+};
+
+#endif
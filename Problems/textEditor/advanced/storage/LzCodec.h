@@ -0,0 +1,165 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include<string>
+#include<string_view>
+#include<vector>
+#include<cstring>
+#include<cstdint>
+#include<algorithm>
+
+using namespace std;
+
+// Byte-oriented LZ77 codec in the style of LZ4, for blocks of up to 64 KB.
+// A block is a run of sequences, each a token byte (literal count in the
+// high nibble, match length - 4 in the low one; 15 means more length bytes
+// follow, summed until one is below 255), the literals, and a 2-byte
+// little-endian match offset. The last sequence has literals only. Matches
+// are found greedily through a hash table of 4-byte prefixes; decoding is a
+// loop of memcpy.
+class LzCodec{
+private:
+    static const size_t minMatch=4;
+
+    static void putLength(string& out, size_t length){
+        while(length>=255){
+            out.push_back((char)255);
+            length-=255;
+        }
+        out.push_back((char)length);
+    }
+
+    // Number of equal leading bytes of a and b, at most limit; compares
+    // eight bytes at a time.
+    static size_t matchLength(const char* a, const char* b, size_t limit){
+        size_t length=0;
+        while(length+8<=limit){
+            uint64_t x, y;
+            memcpy(&x, a+length, 8);
+            memcpy(&y, b+length, 8);
+            if(x!=y) return length+__builtin_ctzll(x^y)/8;
+            length+=8;
+        }
+        while(length<limit && a[length]==b[length]) length++;
+        return length;
+    }
+
+    // Copies 8 bytes at a time, up to 7 bytes past dst+size; the caller
+    // makes sure there is room. Works for overlapping matches as long as
+    // dst-src is at least 8.
+    static void copyWords(char* dst, const char* src, size_t size){
+        for(size_t i=0;i<size;i+=8){
+            memcpy(dst+i, src+i, 8);
+        }
+    }
+
+    static void putSequence(string& out, const char* literals, size_t literalCount, size_t offset, size_t matchLength){
+        size_t extra=matchLength-minMatch;
+        unsigned char token=(unsigned char)((min<size_t>(literalCount, 15)<<4) | min<size_t>(extra, 15));
+        out.push_back((char)token);
+        if(literalCount>=15) putLength(out, literalCount-15);
+        out.append(literals, literalCount);
+        out.push_back((char)(offset&0xFF));
+        out.push_back((char)(offset>>8));
+        if(extra>=15) putLength(out, extra-15);
+    }
+
+public:
+    static const size_t maxBlock=1<<16;
+
+    // Appends the compressed form of src (at most maxBlock bytes) to out and
+    // returns true, or returns false and leaves out alone if it would not be
+    // smaller than src.
+    static bool compress(string_view src, string& out){
+        static const int hashBits=14;
+        const char* data=src.data();
+        size_t size=src.size();
+        if(size>maxBlock) return false;
+
+        vector<uint32_t> table(1<<hashBits, 0);
+        string block;
+        block.reserve(size);
+        size_t anchor=0;
+        size_t pos=0;
+        size_t misses=0;
+        while(pos+minMatch<=size){
+            uint32_t prefix;
+            memcpy(&prefix, data+pos, 4);
+            uint32_t slot=(prefix*2654435761u)>>(32-hashBits);
+            size_t candidate=table[slot];
+            table[slot]=(uint32_t)pos;
+            if(candidate<pos && pos-candidate<=0xFFFF && memcmp(data+candidate, data+pos, minMatch)==0){
+                size_t length=minMatch+matchLength(data+candidate+minMatch, data+pos+minMatch, size-pos-minMatch);
+                putSequence(block, data+anchor, pos-anchor, pos-candidate, length);
+                pos+=length;
+                anchor=pos;
+                misses=0;
+                if(block.size()>=size) return false;
+            } else {
+                // Skip ahead faster through data that does not compress.
+                pos+=1+(misses++>>6);
+            }
+        }
+
+        size_t literalCount=size-anchor;
+        block.push_back((char)(min<size_t>(literalCount, 15)<<4));
+        if(literalCount>=15) putLength(block, literalCount-15);
+        block.append(data+anchor, literalCount);
+        if(block.size()>=size) return false;
+        out.append(block);
+        return true;
+    }
+
+    // Decodes src into exactly size bytes at dst. Returns false for corrupt
+    // input instead of reading or writing out of bounds.
+    static bool decompress(string_view src, char* dst, size_t size){
+        const unsigned char* in=(const unsigned char*)src.data();
+        const unsigned char* inEnd=in+src.size();
+        char* out=dst;
+        char* outEnd=dst+size;
+
+        auto readLength=[&](size_t& length){
+            unsigned char byte;
+            do{
+                if(in==inEnd) return false;
+                byte=*in++;
+                length+=byte;
+            } while(byte==255);
+            return true;
+        };
+
+        while(in<inEnd){
+            unsigned char token=*in++;
+            size_t literalCount=token>>4;
+            if(literalCount==15 && !readLength(literalCount)) return false;
+            if(literalCount>(size_t)(inEnd-in) || literalCount>(size_t)(outEnd-out)) return false;
+            if(literalCount+8<=(size_t)(inEnd-in) && literalCount+8<=(size_t)(outEnd-out)){
+                copyWords(out, (const char*)in, literalCount);
+            } else {
+                memcpy(out, in, literalCount);
+            }
+            in+=literalCount;
+            out+=literalCount;
+            if(in==inEnd) break;
+
+            if(inEnd-in<2) return false;
+            size_t offset=in[0] | (size_t)in[1]<<8;
+            in+=2;
+            size_t length=(token&15)+minMatch;
+            if((token&15)==15 && !readLength(length)) return false;
+            if(offset==0 || offset>(size_t)(out-dst) || length>(size_t)(outEnd-out)) return false;
+            const char* match=out-offset;
+            if(offset>=8 && length+8<=(size_t)(outEnd-out)){
+                copyWords(out, match, length);
+            } else if(offset>=length){
+                memcpy(out, match, length);
+            } else {
+                for(size_t i=0;i<length;i++) out[i]=match[i];
+            }
+            out+=length;
+        }
+        return out==outEnd;
+    }
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include<string>
+#include<string_view>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+using namespace std;
+
+// Read-only mapping of a whole file. Pages are only read in when touched.
+class MappedFile{
+private:
+    void* data=nullptr;
+    size_t size=0;
+    bool opened=false;
+
+public:
+    MappedFile(const string& path){
+        int fd=::open(path.c_str(), O_RDONLY);
+        if(fd<0) return;
+        struct stat info;
+        if(::fstat(fd, &info)==0){
+            size=info.st_size;
+            if(size==0){
+                opened=true;
+            } else {
+                void* mapped=::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(mapped!=MAP_FAILED){
+                    data=mapped;
+                    opened=true;
+                }
+            }
+        }
+        // The mapping stays valid after the descriptor is closed.
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&)=delete;
+    MappedFile& operator=(const MappedFile&)=delete;
+
+    ~MappedFile(){
+        if(data!=nullptr) ::munmap(data, size);
+    }
+
+    bool ok() const{
+        return opened;
+    }
+
+    string_view contents() const{
+        return string_view((const char*)data, data ? size : 0);
+    }
+};
+
+#endif
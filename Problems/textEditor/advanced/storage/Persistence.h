@@ -0,0 +1,43 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include<string>
+#include<vector>
+#include "../models/Document.h"
+
+using namespace std;
+
+// Replace `erased` bytes at `offset` of the rendered document with `text`.
+struct TextChange{
+    size_t offset;
+    size_t erased;
+    string text;
+};
+
+class Persistence{
+public:
+    virtual void save(const string& data)=0;
+
+    // Backends that can stream override this; the default renders the
+    // document into one string first. May run on a background thread, so it
+    // works on a snapshot rather than on the live document.
+    virtual void saveDocument(const Document::Snapshot& document){
+        save(document.render());
+    }
+
+    // Backends that can persist just the edits made since the last save
+    // return true here and implement saveChanges(); the editor then sends
+    // them the changes instead of the whole document. saveChanges() returns
+    // false if it could not, and the editor falls back to saveDocument().
+    virtual bool supportsChanges() const{
+        return false;
+    }
+
+    virtual bool saveChanges(const vector<TextChange>&){
+        return false;
+    }
+
+    virtual ~Persistence(){}
+};
+
+#endif
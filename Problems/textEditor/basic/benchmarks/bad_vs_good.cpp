@@ -0,0 +1,307 @@
+// Benchmarks the monolithic editor (bad.cpp) against the layered one
+// (good.cpp) across document sizes: add throughput and allocations per add,
+// first and cached render latency, save throughput and peak RSS, plus a
+// micro benchmark of the extension check in bad.cpp's renderer().
+//
+// Every case runs in a forked child so peak RSS is per case; each case runs
+// `runs` times and the best time is kept (allocation counts are exact and
+// the same every run). Saves go to a temporary directory.
+//
+// Output is CSV on stdout, one measurement per row:
+//   benchmark,design,elements,metric,value,unit
+//
+//   g++ -std=c++17 -O2 bad_vs_good.cpp -o bad_vs_good && ./bad_vs_good [elements...]
+
+#include<iostream>
+#include<sstream>
+#include<fstream>
+#include<vector>
+#include<string>
+#include<chrono>
+#include<algorithm>
+#include<new>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<unistd.h>
+#include<sys/wait.h>
+#include<sys/resource.h>
+
+// Both files define main() and the same class names; each gets its own
+// namespace. The standard headers above are already included, so their
+// #includes inside the namespaces expand to nothing.
+#define main badMain
+namespace bad {
+#include "../bad.cpp"
+}
+#undef main
+#define main goodMain
+namespace good {
+#include "../good.cpp"
+}
+#undef main
+
+using namespace std;
+
+// Counts every allocation made through operator new.
+static size_t allocations=0;
+
+void* operator new(size_t size){
+    allocations++;
+    if(void* p=malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size){
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept{
+    free(p);
+}
+
+static const string line="The quick brown fox jumps over the lazy dog, again and again.";
+static const string picture="picture.jpg";
+// One element in imageEvery is an image.
+static const size_t imageEvery=10;
+
+// Drives both editors through the same steps; each added item is one line.
+struct BadEditor{
+    bad::DocumentEditor editor;
+
+    void addText(const string& text){
+        editor.addText(text);
+    }
+
+    void addImage(const string& path){
+        editor.addImage(path);
+    }
+
+    string render(){
+        return editor.renderer();
+    }
+
+    void save(){
+        editor.saveToFile();
+    }
+};
+
+struct GoodEditor{
+    good::Document document;
+    good::FileStorage storage;
+    good::DocumentEditor editor{&document, &storage};
+
+    void addText(const string& text){
+        editor.addText(text);
+        editor.addNewLine();
+    }
+
+    void addImage(const string& path){
+        editor.addImage(path);
+        editor.addNewLine();
+    }
+
+    string render(){
+        return editor.renderDocument();
+    }
+
+    void save(){
+        editor.saveDocument();
+    }
+};
+
+struct Measurement{
+    double addNanosPerOp;
+    double addAllocationsPerOp;
+    double renderMillis;
+    double renderAllocations;
+    double cachedRenderMillis;
+    double saveMegabytesPerSecond;
+    double renderedBytes;
+    double peakRssKilobytes;
+};
+
+template<typename F>
+double millis(F fn){
+    auto start=chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now()-start).count();
+}
+
+template<typename Editor>
+Measurement measure(size_t elements){
+    Measurement m={};
+    Editor* editor=new Editor();
+
+    size_t before=allocations;
+    double addMillis=millis([&]{
+        for(size_t i=0;i<elements;i++){
+            if(i%imageEvery==imageEvery-1){
+                editor->addImage(picture);
+            } else {
+                editor->addText(line);
+            }
+        }
+    });
+    m.addNanosPerOp=addMillis*1e6/elements;
+    m.addAllocationsPerOp=(double)(allocations-before)/elements;
+
+    size_t bytes=0;
+    before=allocations;
+    m.renderMillis=millis([&]{ bytes=editor->render().size(); });
+    m.renderAllocations=allocations-before;
+    m.cachedRenderMillis=millis([&]{ bytes=editor->render().size(); });
+    m.renderedBytes=bytes;
+
+    // Both editors print a line per save.
+    ostringstream quiet;
+    streambuf* console=cout.rdbuf(quiet.rdbuf());
+    double saveMillis=millis([&]{ editor->save(); });
+    cout.rdbuf(console);
+    m.saveMegabytesPerSecond=bytes/1e6/(saveMillis/1000);
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    m.peakRssKilobytes=usage.ru_maxrss;
+    // good.cpp never frees its elements, so neither design is torn down.
+    return m;
+}
+
+// Runs fn in a child process and returns what it measured.
+template<typename F>
+bool inChild(F fn, Measurement& result){
+    int fds[2];
+    if(pipe(fds)!=0) return false;
+    pid_t pid=fork();
+    if(pid==0){
+        close(fds[0]);
+        Measurement m=fn();
+        ssize_t written=write(fds[1], &m, sizeof(m));
+        _exit(written==(ssize_t)sizeof(m) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got=pid>0 ? read(fds[0], &result, sizeof(result)) : -1;
+    close(fds[0]);
+    int status=0;
+    if(pid>0) waitpid(pid, &status, 0);
+    return got==(ssize_t)sizeof(result) && WIFEXITED(status) && WEXITSTATUS(status)==0;
+}
+
+void report(const char* benchmark, const char* design, size_t elements, const char* metric, double value, const char* unit){
+    printf("%s,%s,%zu,%s,%.10g,%s\n", benchmark, design, elements, metric, value, unit);
+}
+
+template<typename Editor>
+void editorCase(const char* design, size_t elements, int runs){
+    Measurement best={};
+    bool any=false;
+    for(int run=0;run<runs;run++){
+        Measurement m;
+        if(!inChild([&]{ return measure<Editor>(elements); }, m)) continue;
+        if(!any){
+            best=m;
+            any=true;
+            continue;
+        }
+        best.addNanosPerOp=min(best.addNanosPerOp, m.addNanosPerOp);
+        best.renderMillis=min(best.renderMillis, m.renderMillis);
+        best.cachedRenderMillis=min(best.cachedRenderMillis, m.cachedRenderMillis);
+        best.saveMegabytesPerSecond=max(best.saveMegabytesPerSecond, m.saveMegabytesPerSecond);
+        best.peakRssKilobytes=min(best.peakRssKilobytes, m.peakRssKilobytes);
+    }
+    if(!any){
+        fprintf(stderr, "%s with %zu elements failed\n", design, elements);
+        return;
+    }
+    report("macro", design, elements, "add_time", best.addNanosPerOp, "ns/op");
+    report("macro", design, elements, "add_allocations", best.addAllocationsPerOp, "allocs/op");
+    report("macro", design, elements, "render_latency", best.renderMillis, "ms");
+    report("macro", design, elements, "render_allocations", best.renderAllocations, "allocs");
+    report("macro", design, elements, "cached_render_latency", best.cachedRenderMillis, "ms");
+    report("macro", design, elements, "save_throughput", best.saveMegabytesPerSecond, "MB/s");
+    report("macro", design, elements, "rendered_size", best.renderedBytes, "bytes");
+    report("macro", design, elements, "peak_rss", best.peakRssKilobytes, "KB");
+}
+
+// bad.cpp's renderer() tests each element with two substr() calls; compare
+// against compare(), which checks the suffix in place.
+void extensionCheck(size_t elements, int runs){
+    vector<string> items;
+    for(size_t i=0;i<elements;i++){
+        items.push_back(i%imageEvery==imageEvery-1 ? picture : line);
+    }
+    volatile size_t images=0;
+    auto bySubstr=[&]{
+        size_t found=0;
+        for(auto& element : items){
+            if(element.size()>4 && (element.substr(element.size()-4)==".jpg" ||
+                                    element.substr(element.size()-4)==".png")) found++;
+        }
+        images=found;
+    };
+    auto byCompare=[&]{
+        size_t found=0;
+        for(auto& element : items){
+            if(element.size()>4 && (element.compare(element.size()-4, 4, ".jpg")==0 ||
+                                    element.compare(element.size()-4, 4, ".png")==0)) found++;
+        }
+        images=found;
+    };
+    double substrMillis=1e300, compareMillis=1e300;
+    size_t substrAllocations=0, compareAllocations=0;
+    for(int run=0;run<runs;run++){
+        size_t before=allocations;
+        substrMillis=min(substrMillis, millis(bySubstr));
+        substrAllocations+=allocations-before;
+        before=allocations;
+        compareMillis=min(compareMillis, millis(byCompare));
+        compareAllocations+=allocations-before;
+    }
+    report("micro", "extension_substr", elements, "check_time", substrMillis*1e6/elements, "ns/op");
+    report("micro", "extension_substr", elements, "check_allocations", (double)substrAllocations/runs/elements, "allocs/op");
+    report("micro", "extension_compare", elements, "check_time", compareMillis*1e6/elements, "ns/op");
+    report("micro", "extension_compare", elements, "check_allocations", (double)compareAllocations/runs/elements, "allocs/op");
+}
+
+int main(int argc, char** argv){
+    vector<size_t> sizes;
+    for(int i=1;i<argc;i++){
+        sizes.push_back(strtoull(argv[i], nullptr, 10));
+    }
+    if(sizes.empty()) sizes={1000, 10000, 100000, 1000000};
+    const int runs=3;
+
+    char directory[]="/tmp/bad_vs_good.XXXXXX";
+    if(mkdtemp(directory)==nullptr || chdir(directory)!=0){
+        perror("temporary directory");
+        return 1;
+    }
+
+    printf("benchmark,design,elements,metric,value,unit\n");
+    fflush(stdout);
+    for(size_t elements : sizes){
+        if(elements==0) continue;
+        editorCase<BadEditor>("bad", elements, runs);
+        fflush(stdout);
+        editorCase<GoodEditor>("good", elements, runs);
+        fflush(stdout);
+        extensionCheck(elements, runs);
+        fflush(stdout);
+    }
+
+    unlink("document.txt");
+    if(chdir("/")==0) rmdir(directory);
+    return 0;
+}